@@ -0,0 +1,53 @@
+#ifndef __GridCSR_Codec_h__
+#define __GridCSR_Codec_h__
+
+#include <GridCSR/GridCSR.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace GridCSR {
+
+// Compressed .col files, recorded as MetaData::codec. Layout:
+//   ColHeader
+//   blocks of 128 values (the last one may be shorter): one control byte per 4 values, two bits
+//   each giving the byte length (1 to 4) of a value, then the values' little-endian bytes
+// A value is the difference to the ID before it, modulo 2^32, so the sorted IDs of a row take one
+// or two bytes each. The first ID of a row wraps around to a 4 byte value, which is why decoding
+// needs no .ptr: a prefix sum over all of them gives back the IDs.
+char const * const COLCODEC = "delta-streamvbyte";
+
+struct ColHeader {
+    uint64_t magic;
+    uint64_t count; // IDs, the decoded file is count * sizeof(Vertex) bytes
+};
+
+// bytes an encoding of count IDs takes at most, the header included
+size_t colBound(size_t const count);
+
+// Encodes the IDs of one .col file in pieces; every piece but the last one holds a multiple of
+// 128 IDs, so the blocks of all pieces line up.
+class ColEncoder {
+private:
+    Vertex prev = 0;
+    uint64_t count = 0;
+
+public:
+    // out has room for colBound(count) - sizeof(ColHeader) bytes; returns the bytes written
+    size_t put(Vertex const * in, size_t const count, uint8_t * out);
+
+    // goes in front of all pieces once they are encoded
+    ColHeader header() const;
+};
+
+// IDs in an encoded file, which starts at in and is byte bytes long; throws std::runtime_error
+// when it is no encoded file
+size_t colCount(void const * in, size_t const byte);
+
+// inflates an encoded file to out, which has room for colCount(in, byte) IDs; SIMD when built for
+// SSSE3 or AVX2
+void colDecode(void const * in, size_t const byte, Vertex * out);
+
+} // namespace GridCSR
+
+#endif
@@ -29,8 +29,27 @@ struct Edge {
 struct MetaData {
     std::string dataname;
 
+    // container holding every grid, see GridCSR/Pack.h; empty when each grid is its own files
+    std::string pack;
+
+    // encoding of the .col files, see GridCSR/Codec.h; empty when they are plain Vertex arrays
+    std::string codec;
+
+    // folders of delta datasets below this one, oldest first: edges added since the conversion,
+    // which a Reader merges into the grids and GridCSRCompact folds into them for good
+    std::vector<std::string> delta;
+
+    // folder of the dataset holding the transposed grids, relative to this one, as written in the
+    // same conversion; the transposed dataset names this one ".."; empty when there is none
+    std::string transpose;
+
+    // edges the grids hold: "lower" only src > dst, "upper" only src < dst, "symmetric" both
+    // directions of every edge, "plain" as converted; empty in metadata of older converters
+    std::string orientation;
+
+    // idx is empty unless every grid has a row index, see GridCSR/RowIndex.h
     struct {
-        std::string row, ptr, col;
+        std::string row, ptr, col, idx;
     } extension;
 
     struct {
@@ -51,8 +70,31 @@ struct MetaData {
                 size_t row, col;
             } index;
             std::string name;
+
+            // the rest is only known when detail is set
+            size_t depth; // quadtree depth of a shard, 0 for a whole grid
+            struct {
+                size_t row, col;
+            } shard;
+            struct {
+                struct {
+                    size_t begin, end; // global vertex IDs
+                } row, col;
+            } range;
+            struct {
+                size_t row, ptr, col, idx = 0;
+            } byte; // of the files, an encoded .col is smaller than count.edge IDs
+            struct {
+                size_t edge, row;
+            } count;
+            size_t max_row; // edges in the longest row
+            size_t ptr_bits = 32; // of a .ptr entry, 64 in a grid of 2^32 edges or more
         };
         std::vector<GridInfo> each;
+
+        // every grid of the dataset is listed with its statistics, so no reader has to scan the
+        // folder; metadata of older converters only has the indices and names
+        bool detail = false;
     } grid;
 
     void Load(FS::path const & filePath);
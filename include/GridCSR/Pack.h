@@ -0,0 +1,95 @@
+#ifndef __GridCSR_Pack_h__
+#define __GridCSR_Pack_h__
+
+#include <GridCSR/GridCSR.h>
+
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GridCSR {
+
+// Single-file container of a whole dataset, an alternative to one .row/.ptr/.col file triple per
+// grid. Layout:
+//   PackHeader, padded to align
+//   segments, each starting at a multiple of align (4KB pages, or 2MB for hugepage mappings)
+//   table at tableOffset: per grid {nameOffset, nameByte, files * {offset, byte}}, all uint64_t,
+//   then the grid names back to back; nameOffset counts from the end of the per-grid records
+// A grid's files are its segments in the MetaData extension order: row, ptr, col, then idx when
+// the dataset has row indexes.
+
+struct PackHeader {
+    uint64_t magic, version;
+    uint64_t align;       // segment alignment in bytes, a power of two
+    uint64_t files;       // segments per grid
+    uint64_t grids;
+    uint64_t tableOffset; // byte offset of the grid table
+    uint64_t tableByte;
+};
+
+struct PackSegment {
+    uint64_t offset, byte;
+};
+
+// Appends grids to a new container; put() is thread-safe and writes outside of the lock.
+class PackWriter {
+private:
+    struct Entry {
+        std::string name;
+        std::vector<PackSegment> segment;
+    };
+
+    int fd = -1;
+    std::mutex lock;
+    uint64_t align, files, end;
+    std::vector<Entry> entries;
+
+public:
+    void init(FS::path const & path, size_t const align, size_t const files);
+    ~PackWriter() noexcept;
+
+    // data[i] holds byte[i] bytes of the grid's i-th file
+    void put(std::string const & name, void const * const * data, size_t const * byte);
+
+    // writes the table and the header; the caller syncs and renames the file
+    void close();
+};
+
+// Read-only container, mmap()ed as a whole. Segments are served either as pointers into the
+// mapping or copied out with pread(), whichever the caller's buffers want.
+class Pack {
+private:
+    int fd = -1;
+    uint8_t const * addr = nullptr;
+    size_t byte = 0;
+    PackHeader header;
+    std::vector<std::string> names;
+    std::vector<PackSegment> segments; // grids * files
+    std::unordered_map<std::string, size_t> index;
+
+public:
+    FS::path path;
+
+    void open(FS::path const & path);
+    ~Pack() noexcept;
+
+    size_t grids() const { return this->names.size(); }
+    size_t files() const { return this->header.files; }
+    size_t align() const { return this->header.align; }
+    std::string const & name(size_t const grid) const { return this->names[grid]; }
+
+    // throws std::out_of_range for a grid that is not in the container
+    PackSegment const & segment(std::string const & name, size_t const file) const;
+
+    // pointer into the mapping, valid as long as the Pack lives
+    void const * data(std::string const & name, size_t const file) const;
+
+    // copies the segment to dst, which has room for segment(name, file).byte bytes
+    void read(std::string const & name, size_t const file, void * dst) const;
+};
+
+} // namespace GridCSR
+
+#endif
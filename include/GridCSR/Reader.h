@@ -0,0 +1,178 @@
+#ifndef __GridCSR_Reader_h__
+#define __GridCSR_Reader_h__
+
+#include <GridCSR/GridCSR.h>
+#include <GridCSR/Pack.h>
+#include <GridCSR/RowIndex.h>
+
+#include <array>
+#include <memory>
+#include <stddef.h>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GridCSR {
+
+// count values of type T that someone else owns
+template <typename T>
+struct Span {
+    T const * addr = nullptr;
+    size_t count = 0;
+
+    T const * begin() const { return this->addr; }
+    T const * end() const { return this->addr + this->count; }
+    T const & operator[](size_t const i) const { return this->addr[i]; }
+    size_t byte() const { return this->count * sizeof(T); }
+};
+
+// One file of a grid as it is in memory, an encoded .col already decoded. The memory stays valid as
+// long as a copy of the view holds it.
+struct FileView {
+    void const * addr = nullptr;
+    size_t byte = 0;
+    std::shared_ptr<void const> hold;
+};
+
+// The files of a grid, typed
+struct GridView {
+    std::array<FileView, 4> file; // in the MetaData extension order: row, ptr, col, idx
+
+    bool hasIndex() const { return this->file[3].addr != nullptr; }
+
+    Span<Vertex> row() const { return span<Vertex>(this->file[0]); }
+    Span<Vertex> col() const { return span<Vertex>(this->file[2]); }
+
+    // bits of a .ptr entry, 32 or 64; .ptr has one entry more than .row
+    size_t ptrBits() const { return 8 * this->file[1].byte / (this->row().count + 1); }
+
+    // throws std::runtime_error when the entries are not Index
+    template <typename Index>
+    Span<Index> ptr() const {
+        if (this->ptrBits() != 8 * sizeof(Index)) {
+            throw std::runtime_error("the .ptr entries of the grid are not " +
+                                     std::to_string(8 * sizeof(Index)) + " bits");
+        }
+        return span<Index>(this->file[1]);
+    }
+
+    // throws std::runtime_error when the grid has no row index
+    RowIndex rowIndex() const {
+        if (!this->hasIndex()) {
+            throw std::runtime_error("the grid has no row index");
+        }
+        auto r = this->row();
+        return RowIndex(this->file[3].addr, this->file[3].byte, r.addr, r.count);
+    }
+
+private:
+    template <typename T>
+    static Span<T> span(FileView const & f) {
+        Span<T> s;
+        s.addr = (T const *)f.addr;
+        s.count = f.byte / sizeof(T);
+        return s;
+    }
+};
+
+// Memory for the views that are not mapped files: decoded .col files, and every file of a reader
+// that copies. An engine passes its own to have the files land in pinned or device-visible memory.
+class BufferProvider {
+public:
+    virtual ~BufferProvider() = default;
+
+    // throws std::bad_alloc
+    virtual void * alloc(size_t const byte) = 0;
+    virtual void free(void * addr, size_t const byte) noexcept = 0;
+};
+
+// Read-only access to a dataset, whichever way the converter stored it: one file triple per grid or
+// a Pack, plain or encoded .col files. A dataset with deltas is served as one: a grid some delta
+// has is the sorted union of its edges in all of them. Every method is thread-safe once open()
+// returned.
+class Reader {
+private:
+    std::shared_ptr<Pack> pack;
+    std::shared_ptr<BufferProvider> provider;
+    bool mapped = true;
+
+    std::array<std::string, 4> extension;
+    std::vector<std::array<size_t, 4>> stored, bytes; // in the folder and in memory
+    std::unordered_map<std::string, size_t> index;
+
+    // a grid of the dataset itself or of one of its deltas
+    struct Part {
+        Reader const * reader;
+        size_t grid;
+    };
+    std::vector<std::shared_ptr<Reader>> deltas;
+    std::vector<std::vector<Part>> parts; // of a grid that is merged, empty otherwise
+
+    FS::path filePath(size_t const grid, size_t const type) const;
+    bool encoded(size_t const type) const;
+
+    // the file as it is stored, mapped in place
+    FileView map(size_t const grid, size_t const type) const;
+
+    // byte bytes of the provider
+    FileView buffer(size_t const byte) const;
+
+    // a file of the dataset itself, no delta merged in
+    void readStored(size_t const grid, size_t const type, void * dst) const;
+
+    struct MergeStat {
+        size_t rows = 0, edges = 0, maxRow = 0;
+    };
+
+    // in delta.cpp: opens meta.delta and sizes the merged grids; merge() writes the files of a
+    // merged grid to the outputs that are not null, and only counts with all of them null
+    void openDeltas();
+    FileView partFile(Part const & p, size_t const type) const;
+    void merge(size_t const grid,
+               Vertex * row,
+               void * ptr,
+               Vertex * col,
+               MergeStat * stat = nullptr) const;
+
+public:
+    FS::path folder;
+
+    // the folder's meta.json; without one, meta only names the grids of the non-empty .row files
+    // and row indexes are not used. With deltas, their grids are listed after the dataset's own,
+    // with the statistics of the merged grids.
+    MetaData meta;
+    bool hasMeta = false;
+
+    // views are mapped files, or buffers of provider when one is given; throws std::runtime_error
+    void open(FS::path const & folder, std::shared_ptr<BufferProvider> provider = nullptr);
+
+    size_t grids() const { return this->meta.grid.each.size(); }
+
+    // file types of a grid: 4 when the dataset has row indexes, 3 otherwise
+    size_t files() const { return (this->meta.extension.idx.empty()) ? 3 : 4; }
+
+    // a grid some delta has edges of; it is built up on every file() and read()
+    bool merged(size_t const grid) const { return !this->parts[grid].empty(); }
+
+    // position of a grid in meta.grid.each; throws std::out_of_range for an unknown name
+    size_t find(std::string const & name) const { return this->index.at(name); }
+
+    // of a file in memory, type in the MetaData extension order
+    size_t byte(size_t const grid, size_t const type) const { return this->bytes[grid][type]; }
+
+    // bits of a .ptr entry of a grid, 32 or 64
+    size_t ptrBits(size_t const grid) const {
+        return 8 * this->byte(grid, 1) / (this->byte(grid, 0) / sizeof(Vertex) + 1);
+    }
+
+    FileView file(size_t const grid, size_t const type) const;
+    GridView view(size_t const grid) const;
+
+    // copies a file to dst, which has room for byte(grid, type) bytes
+    void read(size_t const grid, size_t const type, void * dst) const;
+};
+
+} // namespace GridCSR
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef __GridCSR_RowIndex_h__
+#define __GridCSR_RowIndex_h__
+
+#include <GridCSR/GridCSR.h>
+
+#include <algorithm>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace GridCSR {
+
+// Row index of a grid, recorded as MetaData::extension.idx: where a row ID sits in .row, without
+// the dense lookup of width + 1 entries an engine would otherwise build per job. Layout:
+//   RowIndexHeader
+//   uint32_t dir[blocks + 1], blocks = ceil(width / 2^shift): dir[b] rows have an ID below
+//   b << shift, dir[blocks] is the row count
+// shift is the smallest one with no more blocks than rows, so the file is about as large as .row.
+// A grid with a row in every block gets shift 0, which makes dir a dense rank table.
+struct RowIndexHeader {
+    uint64_t magic;
+    uint64_t width; // row IDs are below it
+    uint64_t rows;
+    uint64_t shift;
+};
+
+// bytes of the index of rows row IDs below width
+size_t rowIndexByte(size_t const width, size_t const rows);
+
+// writes the index of the sorted IDs in row to out, which has room for rowIndexByte(width, rows)
+void rowIndexBuild(Vertex const * row, size_t const rows, size_t const width, void * out);
+
+class RowIndex {
+private:
+    Vertex const * row = nullptr;
+    uint32_t const * dir = nullptr;
+    uint64_t width = 0, rows = 0, shift = 0;
+
+public:
+    RowIndex() = default;
+
+    // an index of byte bytes at idx over the rows IDs at row; throws std::runtime_error when it is
+    // no index of them
+    RowIndex(void const * idx, size_t const byte, Vertex const * row, size_t const rows);
+
+    // position of v in .row, or of the first row after it when v has no edges
+    size_t rank(Vertex const v) const {
+        if (v >= this->width) {
+            return this->rows;
+        }
+        auto b = v >> this->shift;
+        return std::lower_bound(this->row + this->dir[b], this->row + this->dir[b + 1], v) -
+               this->row;
+    }
+
+    // [begin, end) of the edges of v, given the grid's .ptr; empty when v has none
+    template <typename Index>
+    void find(Vertex const v, Index const * ptr, Index & begin, Index & end) const {
+        auto r = this->rank(v);
+        if (r < this->rows && this->row[r] == v) {
+            begin = ptr[r];
+            end = ptr[r + 1];
+        } else {
+            begin = end = 0;
+        }
+    }
+};
+
+} // namespace GridCSR
+
+#endif
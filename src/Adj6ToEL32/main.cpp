@@ -8,20 +8,28 @@
 int main(int argc, char * argv[])
 {
 	// Variables
-	fs::path inFolder, outFolder;
-	bool	 lowerTriangular = false;
+	fs::path	inFolder, outFolder;
+	std::string outName;
+	bool		lowerTriangular = false;
+	uint32_t	gridWidth		= 0;
 
 	// Parse argument
+	auto options = parseOptions(argc, argv);
+
 	switch (argc) {
 	case 5:
 		inFolder  = fs::absolute(fs::path(std::string(argv[1])));
-		outFolder = fs::absolute(fs::path(std::string(argv[2]))) / fs::path(std::string(argv[3]));
+		outName	  = std::string(argv[3]);
+		outFolder = fs::absolute(fs::path(std::string(argv[2]))) / fs::path(outName);
 		lowerTriangular = (strtol(argv[4], nullptr, 10) != 0);
 		break;
 	default:
 		fprintf(stderr,
 				"usage: \n"
-				"%s <inFolder> <outFolder> <outName> <LowerTriangular>\n",
+				"%s <inFolder> <outFolder> <outName> <LowerTriangular>\n"
+				"options:\n"
+				"  --width=<exp>     grid width 2^exp instead of choosing one\n"
+				"  --gridbyte=<exp>  choose the grid width for 2^exp bytes of edges per grid\n",
 				argv[0]);
 		exit(EXIT_FAILURE);
 	}
@@ -36,13 +44,18 @@ int main(int argc, char * argv[])
 
 	// Start procedure
 	stopwatch("Total Procedure", [&] {
-		sp<std::vector<uint64_t>> relabelTable;
-		stopwatch("Stage1", [&] { stage1(inFolder, outFolder, (1L << 24), lowerTriangular); });
+		// vertex IDs are not known up front, only the edges are bounded
+		gridWidth = gridWidthSelect(options, (1UL << 32), inputEdges(inFolder));
+
+		stopwatch("Stage1", [&] { stage1(inFolder, outFolder, gridWidth, lowerTriangular); });
 		stopwatch("Stage2", [&] { stage2(outFolder, outFolder); });
+
+		metaSave(outFolder, outName, gridWidth, 0);
 	});
 
 	// Finish procedure
-	log(std::string(inFolder) + "->" + std::string(outFolder) + ", completed");
+	log(std::string(inFolder) + "->" + std::string(outFolder) +
+		", grid width: " + std::to_string(gridWidth) + ", completed");
 
 	return 0;
 }
\ No newline at end of file
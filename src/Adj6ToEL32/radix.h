@@ -0,0 +1,125 @@
+#ifndef E29326C1_BB73_4F90_A2FF_9BD8BD64CD28
+#define E29326C1_BB73_4F90_A2FF_9BD8BD64CD28
+
+#include "type.h"
+
+#include <algorithm>
+#include <array>
+#include <string.h>
+#include <tbb/parallel_for.h>
+#include <thread>
+#include <vector>
+
+#define __RADIXMIN (1L << 16) // below this, std::stable_sort wins
+#define __RADIXWC  8		  // edges per write-combining buffer, one cache line
+
+// (src, dst) as one integer; sorts the same way as E32's operator<
+inline uint64_t edgeKey(E32 const & e) { return (uint64_t(e[0]) << 32) | uint64_t(e[1]); }
+
+// Stable LSD radix sort of data[0, count) by key(E32 const &) -> uint64_t, 8 bits per pass.
+// Passes whose byte is the same for every key are skipped, so local IDs below 1 << 24 cost six
+// passes for edgeKey and three for a single endpoint. scratch must hold count edges.
+template <typename KeyFunc>
+void radixSort(E32 * data, size_t const count, E32 * scratch, KeyFunc key)
+{
+	if (count < __RADIXMIN) {
+		std::stable_sort(
+			data, data + count, [&](E32 const & l, E32 const & r) { return key(l) < key(r); });
+		return;
+	}
+
+	using Hist = std::array<size_t, 256>;
+
+	size_t const blocks	  = std::max(1U, std::thread::hardware_concurrency());
+	auto		 blockPos = [&](size_t const b) { return count * b / blocks; };
+
+	// one read over the data for every digit, only to find the passes that can be skipped
+	std::vector<std::array<Hist, 8>> digitHist(blocks);
+	tbb::parallel_for(size_t(0), blocks, [&](size_t const b) {
+		auto & h = digitHist[b];
+		for (auto & d : h) {
+			d.fill(0);
+		}
+		for (size_t i = blockPos(b); i < blockPos(b + 1); i++) {
+			auto k = key(data[i]);
+			for (size_t d = 0; d < 8; d++) {
+				h[d][(k >> (8 * d)) & 0xff]++;
+			}
+		}
+	});
+
+	E32 * in  = data;
+	E32 * out = scratch;
+
+	std::vector<Hist> hist(blocks);
+	for (size_t d = 0; d < 8; d++) {
+		bool trivial = false;
+		for (size_t v = 0; v < 256 && !trivial; v++) {
+			size_t total = 0;
+			for (size_t b = 0; b < blocks; b++) {
+				total += digitHist[b][d][v];
+			}
+			trivial = (total == count);
+		}
+
+		if (trivial) {
+			continue;
+		}
+
+		auto shift = 8 * d;
+
+		// per-block histogram of this digit in the current order
+		tbb::parallel_for(size_t(0), blocks, [&](size_t const b) {
+			hist[b].fill(0);
+			for (size_t i = blockPos(b); i < blockPos(b + 1); i++) {
+				hist[b][(key(in[i]) >> shift) & 0xff]++;
+			}
+		});
+
+		// digit-major, block-minor exclusive sum keeps the pass stable
+		size_t sum = 0;
+		for (size_t v = 0; v < 256; v++) {
+			for (size_t b = 0; b < blocks; b++) {
+				auto c	   = hist[b][v];
+				hist[b][v] = sum;
+				sum += c;
+			}
+		}
+
+		// scatter through cache-line sized buffers per bucket
+		tbb::parallel_for(size_t(0), blocks, [&](size_t const b) {
+			auto &									pos = hist[b];
+			std::vector<std::array<E32, __RADIXWC>> wc(256);
+			std::array<uint8_t, 256>				fill;
+			fill.fill(0);
+
+			for (size_t i = blockPos(b); i < blockPos(b + 1); i++) {
+				auto v = (key(in[i]) >> shift) & 0xff;
+
+				wc[v][fill[v]++] = in[i];
+				if (fill[v] == __RADIXWC) {
+					memcpy(&out[pos[v]], wc[v].data(), __RADIXWC * sizeof(E32));
+					pos[v] += __RADIXWC;
+					fill[v] = 0;
+				}
+			}
+
+			for (size_t v = 0; v < 256; v++) {
+				memcpy(&out[pos[v]], wc[v].data(), fill[v] * sizeof(E32));
+				pos[v] += fill[v];
+			}
+		});
+
+		std::swap(in, out);
+	}
+
+	if (in != data) {
+		tbb::parallel_for(size_t(0), blocks, [&](size_t const b) {
+			memcpy(&data[blockPos(b)],
+				   &in[blockPos(b)],
+				   (blockPos(b + 1) - blockPos(b)) * sizeof(E32));
+		});
+	}
+}
+
+#endif /* E29326C1_BB73_4F90_A2FF_9BD8BD64CD28 */
@@ -0,0 +1,211 @@
+#include "radix.h"
+#include "spill.h"
+#include "util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+#include <unordered_map>
+
+static uint64_t gridKey(E32 const & grid) { return (uint64_t(grid[0]) << 32) | uint64_t(grid[1]); }
+
+void Spiller::init(fs::path const &	   folder,
+				   std::string const & ext,
+				   size_t const		   budgetByte,
+				   size_t const		   chunkByte,
+				   size_t const		   writerCount)
+{
+	this->folder	 = folder;
+	this->ext		 = ext;
+	this->chunkEdges = chunkByte / sizeof(E32);
+
+	// stay within a quarter of the machine; mappers and shufflers need their share too
+	auto physByte = size_t(sysconf(_SC_PHYS_PAGES)) * size_t(sysconf(_SC_PAGE_SIZE));
+	auto budget	  = std::min(budgetByte, physByte / 4);
+	auto chunks	  = (budget / chunkByte > 0) ? budget / chunkByte : 1;
+
+	// left uninitialized, pages are only touched once a chunk is handed out
+	this->arena.reset(new E32[chunks * this->chunkEdges]);
+
+	// bchan capacity is a power of two and holds capacity-1 items; never block on give-back
+	size_t capacity = 2;
+	while (capacity <= chunks) {
+		capacity <<= 1;
+	}
+
+	this->freeChunks = makeSp<bchan<E32 *>>(capacity);
+	for (size_t i = 0; i < chunks; i++) {
+		this->freeChunks->push(&this->arena[i * this->chunkEdges]);
+	}
+
+	for (size_t i = 0; i < writerCount; i++) {
+		this->jobs.push_back(makeSp<bchan<SpillJob>>(capacity));
+		this->writers.push_back(std::thread([this, i] { this->writer(i); }));
+	}
+}
+
+Spiller::~Spiller() noexcept
+{
+	if (!this->writers.empty()) {
+		this->close();
+	}
+}
+
+Spiller::Partition & Spiller::partition(E32 const & grid)
+{
+	auto key = gridKey(grid);
+	auto it	 = this->partitions.find(key);
+	if (it == this->partitions.end()) {
+		auto part	= makeSp<Partition>();
+		part->grid	= grid;
+		part->chunk = nullptr;
+		part->count = 0;
+
+		// another thread may have won the race; insert() then returns its partition
+		it = this->partitions.insert({key, part}).first;
+	}
+	return *it->second;
+}
+
+E32 * Spiller::acquire(Partition const & self)
+{
+	E32 * chunk = nullptr;
+	while (this->freeChunks->pop_wait_for(chunk, std::chrono::milliseconds(10)) !=
+		   boost::fibers::channel_op_status::success) {
+		// the whole arena sits in partially filled chunks, write one of them out early
+		this->evict(self);
+	}
+	return chunk;
+}
+
+bool Spiller::evict(Partition const & self)
+{
+	for (auto & kv : this->partitions) {
+		auto & part = *kv.second;
+
+		// try_lock: the owner of a busy partition may be waiting in acquire() itself
+		if (&part == &self || !part.lock.try_lock()) {
+			continue;
+		}
+
+		bool found = (part.chunk != nullptr);
+		if (found) {
+			this->submit(part);
+		}
+		part.lock.unlock();
+
+		if (found) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// part.lock must be held
+void Spiller::submit(Partition & part)
+{
+	SpillJob job;
+	job.grid  = part.grid;
+	job.chunk = part.chunk;
+	job.count = part.count;
+
+	this->jobs[(part.grid[0] + part.grid[1]) % this->jobs.size()]->push(job);
+
+	part.chunk = nullptr;
+	part.count = 0;
+}
+
+void Spiller::writer(size_t const id)
+{
+	// every grid maps to exactly one writer, so its descriptors are never shared
+	struct Fds {
+		int el, run;
+	};
+	std::unordered_map<uint64_t, Fds> fds;
+	std::unique_ptr<E32[]>			  scratch(new E32[this->chunkEdges]);
+
+	for (auto job : *this->jobs[id]) {
+		auto key = gridKey(job.grid);
+		auto it	 = fds.find(key);
+		if (it == fds.end()) {
+			if (fds.size() >= __SPILLFDS) {
+				::close(fds.begin()->second.el);
+				::close(fds.begin()->second.run);
+				fds.erase(fds.begin());
+			}
+
+			auto path = this->folder / fs::path(fileNameEncode(job.grid, this->ext));
+			auto runs = fs::path(path.string() + __SPILLRUN);
+
+			Fds f;
+			f.el  = open64(path.c_str(), O_CREAT | O_APPEND | O_WRONLY, 0644);
+			f.run = open64(runs.c_str(), O_CREAT | O_APPEND | O_WRONLY, 0644);
+			assert_errno(f.el >= 0 && f.run >= 0);
+
+			it = fds.insert({key, f}).first;
+		}
+
+		// one sorted, duplicate-free run per chunk
+		radixSort(job.chunk, job.count, scratch.get(), edgeKey);
+		uint64_t run = std::unique(job.chunk, job.chunk + job.count) - job.chunk;
+
+		edgeWrite(it->second.el, job.chunk, run);
+		fileWrite(it->second.run, &run, sizeof(run));
+
+		this->freeChunks->push(job.chunk);
+	}
+
+	for (auto & kv : fds) {
+		::close(kv.second.el);
+		::close(kv.second.run);
+	}
+}
+
+void Spiller::push(E32 const & grid, E32 const * edges, size_t const count)
+{
+	auto & part = this->partition(grid);
+
+	std::lock_guard<std::mutex> lg(part.lock);
+
+	size_t pos = 0;
+	while (pos < count) {
+		if (part.chunk == nullptr) {
+			part.chunk = this->acquire(part);
+			part.count = 0;
+		}
+
+		auto n = std::min(count - pos, this->chunkEdges - part.count);
+		memcpy(&part.chunk[part.count], &edges[pos], n * sizeof(E32));
+		part.count += n;
+		pos += n;
+
+		if (part.count == this->chunkEdges) {
+			this->submit(part);
+		}
+	}
+}
+
+void Spiller::close()
+{
+	for (auto & kv : this->partitions) {
+		auto & part = *kv.second;
+
+		std::lock_guard<std::mutex> lg(part.lock);
+		if (part.chunk != nullptr && part.count > 0) {
+			this->submit(part);
+		}
+	}
+
+	for (auto & j : this->jobs) {
+		j->close();
+	}
+
+	for (auto & w : this->writers) {
+		w.join();
+	}
+
+	this->writers.clear();
+	this->jobs.clear();
+	this->partitions.clear();
+}
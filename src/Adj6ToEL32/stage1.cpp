@@ -1,3 +1,4 @@
+#include "spill.h"
 #include "type.h"
 #include "util.h"
 
@@ -14,39 +15,44 @@ static auto make_unordered_map(
 	return std::unordered_map<Key, Val, Hash, Equal>(bucket_count, hash, equal);
 }
 
-static auto mapper(sp<std::vector<uint8_t>> adj6,
-				   sp<bchan<RowPos>>		in,
-				   uint32_t const			gridWidth,
-				   bool const				lowerTriangular)
+static auto mapper(sp<FileView>		   adj6,
+				   sp<bchan<RowBlock>> in,
+				   uint32_t const	   gridWidth,
+				   bool const		   lowerTriangular)
 {
 	auto out = makeSp<bchan<sp<std::vector<GE32>>>>(32);
 	std::thread([=] {
-		for (auto dat : *in) {
-			auto el		  = makeSp<std::vector<GE32>>(dat.cnt);
-			auto selfloop = uint64_t(0);
-
-			for (uint64_t i = 0; i < dat.cnt; i++) {
-				auto src = dat.src;
-				auto dst = be6_le8(&(adj6->at(dat.dstStart + i * 6)));
-
-				if (lowerTriangular && src < dst) {
-					std::swap(src, dst);
-				} else if (src == dst) {
-					selfloop++;
-					continue;
+		std::vector<uint64_t> dstList;
+		for (auto blk : *in) {
+			// a block of n bytes holds at most n/6 edges
+			auto el = makeSp<std::vector<GE32>>();
+			el->reserve((blk.end - blk.begin) / 6);
+
+			forEachRow(*adj6, blk, [&](RowPos const & dat) {
+				dstList.resize(dat.cnt);
+				be6_le8_bulk(&adj6->addr[dat.dstStart], dstList.data(), dat.cnt);
+
+				for (uint64_t i = 0; i < dat.cnt; i++) {
+					auto src = dat.src;
+					auto dst = dstList[i];
+
+					if (lowerTriangular && src < dst) {
+						std::swap(src, dst);
+					} else if (src == dst) {
+						continue;
+					}
+
+					GE32 ge32;
+
+					ge32[0][0] = (uint32_t)(src / gridWidth);
+					ge32[0][1] = (uint32_t)(dst / gridWidth);
+					ge32[1][0] = (uint32_t)(src % gridWidth);
+					ge32[1][1] = (uint32_t)(dst % gridWidth);
+
+					el->push_back(ge32);
 				}
+			});
 
-				GE32 ge32;
-
-				ge32[0][0] = (uint32_t)(src / gridWidth);
-				ge32[0][1] = (uint32_t)(dst / gridWidth);
-				ge32[1][0] = (uint32_t)(src % gridWidth);
-				ge32[1][1] = (uint32_t)(dst % gridWidth);
-
-				el->at(i - selfloop) = ge32;
-			}
-
-			el->resize(el->size() - selfloop);
 			out->push(el);
 		}
 		out->close();
@@ -54,11 +60,9 @@ static auto mapper(sp<std::vector<uint8_t>> adj6,
 	return out;
 }
 
-static void
-shuffler(sp<bchan<sp<std::vector<GE32>>>> in, fs::path const & folder, std::string const & ext)
+static void shuffler(sp<bchan<sp<std::vector<GE32>>>> in, Spiller & spiller)
 {
-
-	auto map = make_unordered_map<E32, sp<std::vector<E32>>>(
+	auto map = make_unordered_map<E32, std::vector<E32>>(
 		8192,
 		[](E32 const & k) {
 			auto a = std::hash<uint64_t>{}(uint64_t(k[0]) << (8 * sizeof(k[0])));
@@ -68,27 +72,16 @@ shuffler(sp<bchan<sp<std::vector<GE32>>>> in, fs::path const & folder, std::stri
 		[](E32 const & kl, E32 const & kr) { return (kl[0] == kr[0] && kl[1] == kr[1]); });
 
 	for (auto dat : *in) {
-		for (auto ge : *dat) {
-			if (map.find(ge[0]) == map.end()) {
-				map[ge[0]] = makeSp<std::vector<E32>>();
-			}
-			map[ge[0]]->push_back(ge[1]);
-
-			// flush
-			if (map[ge[0]]->size() > (1 << 20)) {
-				auto targetFile = folder / fs::path(fileNameEncode(ge[0], ext));
-				fileSaveAppend(targetFile, map[ge[0]]->data(), map[ge[0]]->size() * sizeof(ge[0]));
-				map[ge[0]]->resize(0);
-			}
+		// group the block by grid so each grid takes the spill lock once per block
+		for (auto & ge : *dat) {
+			map[ge[0]].push_back(ge[1]);
 		}
-	}
 
-	// flush
-	for (auto & kv : map) {
-		if (kv.second->size() > 0) {
-			auto targetFile = folder / fs::path(fileNameEncode(kv.first, ext));
-			fileSaveAppend(targetFile, kv.second->data(), kv.second->size() * sizeof(kv.first));
+		for (auto & kv : map) {
+			spiller.push(kv.first, kv.second.data(), kv.second.size());
 		}
+
+		map.clear();
 	}
 }
 
@@ -98,19 +91,22 @@ void stage1(fs::path const & inFolder,
 			bool const		 lowerTriangular)
 {
 
-	auto fListChan = fileList(inFolder, "");
+	auto fListChan = fileMapList(fileList(inFolder, ""));
+
+	Spiller spiller;
+	spiller.init(outFolder, ".el32", __SPILLBUDGET, __SPILLCHUNK, __SPILLWRITERS);
 
 	parallelDo(4, [&](size_t const i) {
-		for (auto & fPath : *fListChan) {
-			stopwatch("Stage1, " + std::string(fPath), [&] {
-				auto adj6		= fileLoad<uint8_t>(fPath);
-				auto rowPosChan = splitAdj6(adj6);
+		for (auto & adj6 : *fListChan) {
+			stopwatch("Stage1, " + std::string(adj6->path), [&] {
+				auto rowChan = splitAdj6(adj6, outFolder);
 
 				parallelDo(128, [&](size_t const i) {
-					auto mapped = mapper(adj6, rowPosChan, gridWidth, lowerTriangular);
-					shuffler(mapped, outFolder, ".el32");
+					auto mapped = mapper(adj6, rowChan, gridWidth, lowerTriangular);
+					shuffler(mapped, spiller);
 				});
 			});
 		}
 	});
+	spiller.close();
 }
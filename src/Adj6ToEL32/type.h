@@ -29,4 +29,9 @@ struct RowPos {
 	size_t src, cnt, dstStart;
 };
 
+// [begin, end) byte range of an Adj6 file that holds whole rows
+struct RowBlock {
+	size_t begin, end;
+};
+
 #endif /* CA0B2FF9_2C71_4DD4_927B_AB0FDD3FD13F */
@@ -1,11 +1,24 @@
 #include "util.h"
 
+#include <GridCSR/GridCSR.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iomanip>
 #include <mutex>
 #include <sstream>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <thread>
+#include <unistd.h>
+
+// pick the simdpp backend from the target flags; without SSSE3 be6_le8_bulk() stays scalar
+#if defined(__AVX2__)
+#define SIMDPP_ARCH_X86_AVX2
+#elif defined(__SSSE3__)
+#define SIMDPP_ARCH_X86_SSSE3
+#endif
+#include <simdpp/simd.h>
 
 static std::mutex __logMtx;
 
@@ -55,7 +68,7 @@ void stopwatch(std::string const & message, std::function<void()> function)
 	}
 }
 
-uint64_t be6_le8(uint8_t * in)
+uint64_t be6_le8(uint8_t const * in)
 {
 	uint64_t out = 0;
 	out |= in[0];
@@ -66,18 +79,116 @@ uint64_t be6_le8(uint8_t * in)
 	return out;
 }
 
+void be6_le8_bulk(uint8_t const * in, uint64_t * out, size_t const count)
+{
+	size_t i = 0;
+#if SIMDPP_USE_SSSE3
+	// each 128-bit lane byte-swaps two 6-byte IDs into the low bytes of two uint64_t and zeroes
+	// the top two bytes; the two lanes are loaded 12 bytes apart so one step decodes four IDs.
+	// a step reads 28 bytes, so stop while at least one more ID follows to stay inside the row.
+	simdpp::uint8<32> const mask =
+		simdpp::make_uint(5, 4, 3, 2, 1, 0, 0x80, 0x80, 11, 10, 9, 8, 7, 6, 0x80, 0x80);
+
+	for (; i + 5 <= count; i += 4) {
+		auto const		  p	 = &in[i * 6];
+		simdpp::uint8<16> lo = simdpp::load_u(p);
+		simdpp::uint8<16> hi = simdpp::load_u(p + 12);
+		simdpp::uint8<32> le = simdpp::permute_zbytes16(simdpp::combine(lo, hi), mask);
+		simdpp::store_u(&out[i], le);
+	}
+#endif
+	for (; i < count; i++) {
+		out[i] = be6_le8(&in[i * 6]);
+	}
+}
+
+void pack24_bulk(E32 const * in, uint8_t * out, size_t const count)
+{
+	size_t i = 0;
+#if SIMDPP_USE_SSSE3
+	// each 128-bit lane drops the zero top byte of four local IDs (two edges, 16 -> 12 bytes).
+	// the lanes are stored 12 bytes apart and each store spills 4 bytes past its 12, so keep one
+	// more edge behind the step for the last store to land on.
+	simdpp::uint8<32> const mask =
+		simdpp::make_uint(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0x80, 0x80, 0x80, 0x80);
+
+	for (; i + 5 <= count; i += 4) {
+		auto const		  p = &out[i * 6];
+		simdpp::uint8<32> le;
+		le = simdpp::load_u((uint8_t const *)&in[i]);
+		le = simdpp::permute_zbytes16(le, mask);
+
+		simdpp::uint8<16> lo, hi;
+		simdpp::split(le, lo, hi);
+		simdpp::store_u(p, lo);
+		simdpp::store_u(p + 12, hi);
+	}
+#endif
+	for (; i < count; i++) {
+		for (size_t j = 0; j < 2; j++) {
+			out[i * 6 + j * 3 + 0] = uint8_t(in[i][j]);
+			out[i * 6 + j * 3 + 1] = uint8_t(in[i][j] >> 8);
+			out[i * 6 + j * 3 + 2] = uint8_t(in[i][j] >> 16);
+		}
+	}
+}
+
+void unpack24_bulk(uint8_t const * in, E32 * out, size_t const count)
+{
+	size_t i = 0;
+#if SIMDPP_USE_SSSE3
+	// the reverse of pack24_bulk(): lanes loaded 12 bytes apart, each widens two edges; a step
+	// reads 28 bytes, so stop while at least one more edge follows.
+	simdpp::uint8<32> const mask =
+		simdpp::make_uint(0, 1, 2, 0x80, 3, 4, 5, 0x80, 6, 7, 8, 0x80, 9, 10, 11, 0x80);
+
+	for (; i + 5 <= count; i += 4) {
+		auto const		  p	 = &in[i * 6];
+		simdpp::uint8<16> lo = simdpp::load_u(p);
+		simdpp::uint8<16> hi = simdpp::load_u(p + 12);
+		simdpp::uint8<32> le = simdpp::permute_zbytes16(simdpp::combine(lo, hi), mask);
+		simdpp::store_u(&out[i], le);
+	}
+#endif
+	for (; i < count; i++) {
+		for (size_t j = 0; j < 2; j++) {
+			auto const p = &in[i * 6 + j * 3];
+			out[i][j]	 = V32(p[0]) | (V32(p[1]) << 8) | (V32(p[2]) << 16);
+		}
+	}
+}
+
+void edgeWrite(int const fp, E32 const * data, size_t const count)
+{
+#ifdef __PACK24
+	static thread_local std::vector<uint8_t> packed;
+	packed.resize(count * __EDGEBYTE);
+	pack24_bulk(data, packed.data(), count);
+	fileWrite(fp, packed.data(), packed.size());
+#else
+	fileWrite(fp, data, count * sizeof(E32));
+#endif
+}
+
 sp<bchan<fs::path>> fileList(fs::path const & folder, std::string const & extension)
 {
 	auto out = makeSp<bchan<fs::path>>(128);
 	std::thread([=] {
 		// recursive iteration
 		for (fs::recursive_directory_iterator iter(folder), end; iter != end; iter++) {
-			// check file is not directory and size is not zero
-			if (fs::is_regular_file(iter->status()) && fs::file_size(iter->path()) != 0) {
+			// check file is not directory and size is not zero; skip files removed meanwhile
+			std::error_code ec;
+			auto			byte = fs::file_size(iter->path(), ec);
+			if (fs::is_regular_file(iter->status()) && !ec && byte != 0) {
 				if (extension != "" && extension != iter->path().extension()) {
 					continue;
 				}
 
+				// row block sidecars older converters left next to the Adj6 files
+				if (extension == "" && iter->path().extension() == __ADJ6IDX) {
+					continue;
+				}
+
 				out->push(fs::absolute(iter->path()));
 			}
 		}
@@ -86,25 +197,183 @@ sp<bchan<fs::path>> fileList(fs::path const & folder, std::string const & extens
 	return out;
 }
 
-sp<bchan<RowPos>> splitAdj6(sp<std::vector<uint8_t>> adj6)
+FileView::~FileView()
+{
+	if (this->mapped) {
+		munmap((void *)this->addr, this->byte);
+	}
+}
+
+sp<FileView> fileMap(fs::path const & path)
 {
-	auto out = makeSp<bchan<RowPos>>(256);
+	auto out	= makeSp<FileView>();
+	out->path	= path;
+	out->byte	= fs::file_size(path);
+	out->mapped = false;
+
+	auto fp = open64(path.c_str(), O_RDONLY);
+	assert_errno(fp >= 0);
+
+	int flags = MAP_PRIVATE;
+#ifdef __MMAP_POPULATE
+	flags |= MAP_POPULATE;
+#endif
+
+	auto addr = mmap64(nullptr, out->byte, PROT_READ, flags, fp, 0);
+	close(fp);
+
+	if (addr != MAP_FAILED) {
+		// rows are parsed front to back, so let the kernel read ahead as far as it can
+		madvise(addr, out->byte, MADV_SEQUENTIAL);
+		madvise(addr, out->byte, MADV_WILLNEED);
+		out->addr	= (uint8_t const *)addr;
+		out->mapped = true;
+	} else {
+		auto p		= fs::path(path);
+		out->buffer = fileLoad<uint8_t>(p);
+		out->addr	= out->buffer->data();
+	}
+
+	return out;
+}
+
+sp<bchan<sp<FileView>>> fileMapList(sp<bchan<fs::path>> in)
+{
+	// the file mapped here waits in the channel while the consumers work on the current ones,
+	// so its readahead (or MAP_POPULATE) overlaps with parsing
+	auto out = makeSp<bchan<sp<FileView>>>(2);
 	std::thread([=] {
-		for (size_t i = 0; i < adj6->size();) {
-			RowPos rPos;
-			rPos.src = be6_le8(&(adj6->at(i)));
-			i += 6;
-			rPos.cnt = be6_le8(&(adj6->at(i)));
-			i += 6;
-			rPos.dstStart = i;
-			out->push(rPos);
-			i += (6 * rPos.cnt);
+		for (auto & path : *in) {
+			out->push(fileMap(path));
 		}
 		out->close();
 	}).detach();
 	return out;
 }
 
+struct Adj6Index {
+	uint64_t magic, fileByte, fileTime, blockByte, blocks;
+	uint64_t pathByte; // the input's absolute path follows, then the blocks
+};
+
+static uint64_t const __ADJ6IDX_MAGIC = 0x32786449366a6441; // "Adj6Idx2"
+
+static uint64_t lastWriteTime(fs::path const & path)
+{
+	return uint64_t(fs::last_write_time(path).time_since_epoch().count());
+}
+
+// the index of an input lives below the output, named after a hash of the input's path; the
+// path, size and mtime inside tell whether it still describes that file
+static fs::path adj6IndexPath(FileView const & adj6, fs::path const & outFolder)
+{
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0')
+		 << std::hash<std::string>{}(fs::absolute(adj6.path).string()) << __ADJ6IDX;
+	return outFolder / __BLOCKDIR / name.str();
+}
+
+// blocks of a previous run, if the index still describes this very file
+static bool
+loadAdj6Index(FileView const & adj6, fs::path const & idxPath, std::vector<RowBlock> & blocks)
+{
+	std::error_code ec;
+	if (!fs::exists(idxPath, ec)) {
+		return false;
+	}
+
+	auto idxFile = idxPath;
+	auto raw	 = fileLoad<uint8_t>(idxFile);
+	if (raw->size() < sizeof(Adj6Index)) {
+		return false;
+	}
+
+	auto idx  = (Adj6Index const *)raw->data();
+	auto path = fs::absolute(adj6.path).string();
+	if (idx->magic != __ADJ6IDX_MAGIC || idx->fileByte != adj6.byte ||
+		idx->fileTime != lastWriteTime(adj6.path) || idx->blockByte != __ADJ6BLOCK ||
+		idx->pathByte != path.size() ||
+		raw->size() != sizeof(Adj6Index) + idx->pathByte + idx->blocks * sizeof(RowBlock) ||
+		memcmp(idx + 1, path.data(), path.size()) != 0) {
+		return false;
+	}
+
+	auto first = (RowBlock const *)((uint8_t const *)(idx + 1) + idx->pathByte);
+	blocks.assign(first, first + idx->blocks);
+	return true;
+}
+
+static void saveAdj6Index(FileView const &				adj6,
+						  fs::path const &				idxPath,
+						  std::vector<RowBlock> const & blocks)
+{
+	auto tmpPath = fs::path(idxPath.string() + ".tmp");
+	auto path	 = fs::absolute(adj6.path).string();
+
+	Adj6Index idx;
+	idx.magic	  = __ADJ6IDX_MAGIC;
+	idx.fileByte  = adj6.byte;
+	idx.fileTime  = lastWriteTime(adj6.path);
+	idx.blockByte = __ADJ6BLOCK;
+	idx.blocks	  = blocks.size();
+	idx.pathByte  = path.size();
+
+	std::error_code ec;
+	fs::create_directories(idxPath.parent_path(), ec);
+
+	auto fp = open64(tmpPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	if (fp < 0) {
+		log("cannot save the row block index " + idxPath.string() + ": " + strerror(errno));
+		return;
+	}
+
+	auto blockByte = ssize_t(blocks.size() * sizeof(RowBlock));
+	auto ok		   = write(fp, &idx, sizeof(idx)) == ssize_t(sizeof(idx)) &&
+			  write(fp, path.data(), path.size()) == ssize_t(path.size()) &&
+			  write(fp, blocks.data(), blockByte) == blockByte;
+	close(fp);
+
+	if (ok) {
+		fs::rename(tmpPath, idxPath, ec);
+	} else {
+		fs::remove(tmpPath, ec);
+	}
+}
+
+sp<bchan<RowBlock>> splitAdj6(sp<FileView> adj6, fs::path const & outFolder)
+{
+	auto out = makeSp<bchan<RowBlock>>(16);
+	std::thread([=] {
+		std::vector<RowBlock> blocks;
+
+		auto idxPath = adj6IndexPath(*adj6, outFolder);
+		if (loadAdj6Index(*adj6, idxPath, blocks)) {
+			for (auto & blk : blocks) {
+				out->push(blk);
+			}
+			out->close();
+			return;
+		}
+
+		// only hop from row header to row header; the mappers parse their blocks themselves
+		RowBlock blk = {0, 0};
+		for (size_t i = 0; i + 12 <= adj6->byte;) {
+			i += 12 + 6 * be6_le8(&adj6->addr[i + 6]);
+
+			if (i - blk.begin >= __ADJ6BLOCK || i + 12 > adj6->byte) {
+				blk.end = (i < adj6->byte) ? i : adj6->byte;
+				out->push(blk);
+				blocks.push_back(blk);
+				blk.begin = blk.end;
+			}
+		}
+		out->close();
+
+		saveAdj6Index(*adj6, idxPath, blocks);
+	}).detach();
+	return out;
+}
+
 std::string fileNameEncode(E32 const & grid, std::string const & ext)
 {
 	return std::to_string(grid[0]) + "-" + std::to_string(grid[1]) + ext;
@@ -122,4 +391,131 @@ void parallelDo(size_t const workers, std::function<void(size_t const)> func)
 			wlist[i].join();
 		}
 	}
-}
\ No newline at end of file
+}
+
+std::unordered_map<std::string, std::string> parseOptions(int & argc, char * argv[])
+{
+	std::unordered_map<std::string, std::string> out;
+
+	int positional = 0;
+	for (int i = 0; i < argc; i++) {
+		auto arg = std::string(argv[i]);
+		if (i > 0 && arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+			auto eq = arg.find('=');
+			if (eq == std::string::npos) {
+				out[arg.substr(2)] = "";
+			} else {
+				out[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+			}
+		} else {
+			argv[positional++] = argv[i];
+		}
+	}
+	argc = positional;
+
+	return out;
+}
+
+uint64_t inputEdges(fs::path const & inFolder)
+{
+	// every 6-byte Adj6 word is a source, a count or an edge; a bound without reading the data
+	uint64_t byte  = 0;
+	auto	 files = fileList(inFolder, "");
+	for (auto & path : *files) {
+		std::error_code ec;
+		auto			b = fs::file_size(path, ec);
+		if (!ec) {
+			byte += b;
+		}
+	}
+	return byte / 6;
+}
+
+// Largest power of two keeping a grid's .col within gridByte when the edges spread evenly over
+// the vertices x vertices matrix, and no wider than needed to hold every vertex in one grid
+static uint32_t gridWidthChoose(uint64_t const vertices, uint64_t const edges, size_t const gridByte)
+{
+	// each grid gets edges * (width / vertices)^2 column IDs of 4 bytes
+	auto limit = double(vertices) * sqrt(double(gridByte) / (4.0 * std::max(edges, uint64_t(1))));
+
+	size_t exp = __GRIDMINEXP;
+	while (exp < __GRIDMAXEXP && (1UL << exp) < vertices && double(1UL << (exp + 1)) <= limit) {
+		exp++;
+	}
+	return 1U << exp;
+}
+
+uint32_t gridWidthSelect(std::unordered_map<std::string, std::string> & options,
+						 uint64_t const								  vertices,
+						 uint64_t const								  edges)
+{
+	uint32_t width;
+	if (options.count("width") > 0) {
+		auto exp = strtol(options["width"].c_str(), nullptr, 10);
+		if (exp < 1 || exp > __GRIDMAXEXP) {
+			fprintf(stderr, "--width takes an exponent in [1, %d]\n", __GRIDMAXEXP);
+			exit(EXIT_FAILURE);
+		}
+		width = 1U << exp;
+	} else {
+		size_t gridByte = __GRIDBYTE;
+		if (options.count("gridbyte") > 0) {
+			gridByte = 1L << strtol(options["gridbyte"].c_str(), nullptr, 10);
+		}
+		width = gridWidthChoose(vertices, edges, gridByte);
+	}
+
+	log("Grid width: " + std::to_string(width) + ", vertices: " + std::to_string(vertices) +
+		", edges: " + std::to_string(edges));
+	return width;
+}
+
+void metaSave(fs::path const &	  folder,
+			  std::string const & name,
+			  uint32_t const	  width,
+			  uint64_t const	  maxVID)
+{
+	using GridInfo = decltype(GridCSR::MetaData::grid)::GridInfo;
+
+	GridCSR::MetaData meta;
+	meta.dataname = name;
+	std::tie(meta.extension.row, meta.extension.ptr, meta.extension.col) =
+		std::make_tuple("", "", ".el32.sorted");
+
+	for (fs::directory_iterator iter(folder), end; iter != end; iter++) {
+		std::error_code ec;
+		if (iter->path().extension() != ".sorted" || fs::file_size(iter->path(), ec) == 0 || ec) {
+			continue;
+		}
+
+		// "<row>-<col>.el32.sorted", edge lists only
+		GridInfo g;
+		g.name = iter->path().stem().stem().string();
+		if (sscanf(g.name.c_str(), "%zu-%zu", &g.index.row, &g.index.col) == 2) {
+			meta.grid.each.push_back(g);
+		}
+	}
+
+	std::sort(meta.grid.each.begin(),
+			  meta.grid.each.end(),
+			  [](GridInfo const & l, GridInfo const & r) {
+				  return std::tie(l.index.row, l.index.col, l.name) <
+						 std::tie(r.index.row, r.index.col, r.name);
+			  });
+
+	meta.info.count.row = 0;
+	meta.info.count.col = 0;
+	for (auto & g : meta.grid.each) {
+		meta.info.count.row = std::max(meta.info.count.row, g.index.row + 1);
+		meta.info.count.col = std::max(meta.info.count.col, g.index.col + 1);
+	}
+
+	meta.info.width.row = width;
+	meta.info.width.col = width;
+
+	// unknown without Stage0 or maxVIDexp; the grids bound it then
+	meta.info.max_vid = (maxVID > 0) ? maxVID
+									 : std::max(meta.info.count.row, meta.info.count.col) * width - 1;
+
+	meta.Save(folder / __METAFILE);
+}
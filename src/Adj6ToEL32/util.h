@@ -1,22 +1,107 @@
 #ifndef F3EBF245_52E8_4579_8E93_6A63B9854C05
 #define F3EBF245_52E8_4579_8E93_6A63B9854C05
 
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define assert_errno(x)                                       \
+	do {                                                      \
+		if (!(x)) {                                           \
+			fprintf(stderr,                                   \
+					"[assert_errno] %s:%d, errno: %d (%s)\n", \
+					__FILE__,                                 \
+					__LINE__,                                 \
+					errno,                                    \
+					strerror(errno));                         \
+			exit(EXIT_FAILURE);                               \
+		}                                                     \
+	} while (0);
+
 #include "type.h"
 
 #include <fcntl.h>
 #include <functional>
 #include <string>
-
-#define __CDEF (1L << 27) // 128MB
-
-void				log(std::string const & s);
-void				stopwatch(std::string const & message, std::function<void()> function);
-uint64_t			be6_le8(uint8_t * in);
-sp<bchan<fs::path>> fileList(fs::path const & folder, std::string const & extension);
-sp<bchan<RowPos>>	splitAdj6(sp<std::vector<uint8_t>> adj6);
-std::string			fileNameEncode(E32 const & grid, std::string const & ext);
-void				parallelDo(size_t workers, std::function<void(size_t)> func);
-size_t				ceil(size_t const x, size_t const y);
+#include <unordered_map>
+
+#define __CDEF		(1L << 27) // 128MB
+#define __ADJ6BLOCK (1L << 20) // 1MB of Adj6 rows per mapper job
+#define __ADJ6IDX	".idx"	   // row block index of an Adj6 file, see splitAdj6()
+#define __BLOCKDIR	"adj6idx"  // folder of the row block indexes, below the output folder
+//#define __MMAP_POPULATE // fault in the whole input file at mmap() time (MAP_POPULATE)
+#define __PACK24 // intermediate .el32 edges as two 24-bit local IDs; needs gridWidth <= 1 << 24
+#define __GRIDBYTE	 (1L << 28) // .col bytes a grid is sized for when the width is chosen
+#define __GRIDMINEXP 12
+#define __GRIDMAXEXP 24			// local IDs stay within 24 bits, see __PACK24
+#define __METAFILE	 "meta.json" // GridCSR::MetaData of the output folder
+
+#ifdef __PACK24
+#define __EDGEBYTE 6 // bytes per intermediate edge
+#else
+#define __EDGEBYTE 8
+#endif
+
+// read-only view of a whole input file, mmap()ed when possible and read() otherwise
+struct FileView {
+	fs::path				 path;
+	uint8_t const *			 addr;
+	size_t					 byte;
+	bool					 mapped;
+	sp<std::vector<uint8_t>> buffer;
+
+	~FileView();
+};
+
+void					log(std::string const & s);
+void					stopwatch(std::string const & message, std::function<void()> function);
+uint64_t				be6_le8(uint8_t const * in);
+void					be6_le8_bulk(uint8_t const * in, uint64_t * out, size_t const count);
+void					pack24_bulk(E32 const * in, uint8_t * out, size_t const count);
+void					unpack24_bulk(uint8_t const * in, E32 * out, size_t const count);
+void					edgeWrite(int const fp, E32 const * data, size_t const count);
+sp<bchan<fs::path>>		fileList(fs::path const & folder, std::string const & extension);
+sp<FileView>			fileMap(fs::path const & path);
+sp<bchan<sp<FileView>>>	fileMapList(sp<bchan<fs::path>> in);
+sp<bchan<RowBlock>>		splitAdj6(sp<FileView> adj6, fs::path const & outFolder);
+std::string				fileNameEncode(E32 const & grid, std::string const & ext);
+void					parallelDo(size_t workers, std::function<void(size_t)> func);
+size_t					ceil(size_t const x, size_t const y);
+
+// "--key=value" and "--key" arguments, removed from argv so positional parsing sees the rest
+std::unordered_map<std::string, std::string> parseOptions(int & argc, char * argv[]);
+
+// grid width and output metadata
+uint64_t inputEdges(fs::path const & inFolder);
+uint32_t gridWidthSelect(std::unordered_map<std::string, std::string> & options,
+						 uint64_t const								  vertices,
+						 uint64_t const								  edges);
+void	 metaSave(fs::path const &	  folder,
+				  std::string const & name,
+				  uint32_t const	  width,
+				  uint64_t const	  maxVID);
+
+// calls func(RowPos const &) for every row of blk
+template <typename Func>
+void forEachRow(FileView const & adj6, RowBlock const & blk, Func func)
+{
+	for (size_t i = blk.begin; i + 12 <= blk.end;) {
+		RowPos rPos;
+		rPos.src = be6_le8(&adj6.addr[i]);
+		i += 6;
+		rPos.cnt = be6_le8(&adj6.addr[i]);
+		i += 6;
+		rPos.dstStart = i;
+		i += (6 * rPos.cnt);
+
+		// truncated row at the end of the file
+		if (i > blk.end) {
+			break;
+		}
+
+		func(rPos);
+	}
+}
 
 template <typename T>
 auto fileSave(fs::path & path, T * data, size_t byte)
@@ -35,6 +120,18 @@ auto fileSave(fs::path & path, T * data, size_t byte)
 	close(fp);
 }
 
+// writes byte bytes of data to an already open descriptor
+template <typename T>
+void fileWrite(int const fp, T const * data, size_t const byte)
+{
+	uint64_t pos = 0;
+	while (pos < byte) {
+		auto b = write(fp, &(((uint8_t const *)data)[pos]), byte - pos);
+		assert_errno(b >= 0);
+		pos += b;
+	}
+}
+
 template <typename T>
 auto fileSaveAppend(fs::path & path, T * data, size_t byte)
 {
@@ -0,0 +1,268 @@
+#include "dataset.h"
+#include "input.h"
+#include "manifest.h"
+#include "util.h"
+
+#include <GridCSR/Codec.h>
+#include <GridCSR/GridCSR.h>
+#include <GridCSR/Pack.h>
+#include <GridCSR/RowIndex.h>
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+uint64_t inputEdges(fs::path const & inFolder)
+{
+	uint64_t edges = 0;
+	auto	 files = fileList(inFolder, "");
+	for (auto & path : *files) {
+		std::error_code ec;
+		auto			b = fs::file_size(path, ec);
+		if (ec || b == 0) {
+			continue;
+		}
+
+		if (inputFormat(path) == InputFormat::Adj6) {
+			// every 6-byte Adj6 word is a source, a count or an edge; a bound without reading it
+			edges += b / 6;
+		} else {
+			// lines per byte in the head of a text file
+			auto text	= fileMap(path);
+			auto sample = std::min(text->byte, size_t(__TEXTBLOCK));
+			auto lines	= std::count(text->addr, text->addr + sample, '\n');
+			edges += uint64_t(double(b) * double(std::max(lines, 1L)) / double(sample));
+		}
+	}
+	return edges;
+}
+
+// Largest power of two keeping a grid's .col within gridByte when the edges spread evenly over
+// the vertices x vertices matrix, and no wider than needed to hold every vertex in one grid
+static uint32_t gridWidthChoose(uint64_t const vertices, uint64_t const edges, size_t const gridByte)
+{
+	// each grid gets edges * (width / vertices)^2 column IDs of 4 bytes
+	auto limit = double(vertices) * sqrt(double(gridByte) / (4.0 * std::max(edges, uint64_t(1))));
+
+	size_t exp = __GRIDMINEXP;
+	while (exp < __GRIDMAXEXP && (1UL << exp) < vertices && double(1UL << (exp + 1)) <= limit) {
+		exp++;
+	}
+	return 1U << exp;
+}
+
+uint32_t gridWidthSelect(std::unordered_map<std::string, std::string> & options,
+						 uint64_t const								  vertices,
+						 uint64_t const								  edges)
+{
+	uint32_t width;
+	if (options.count("width") > 0) {
+		auto exp = strtol(options["width"].c_str(), nullptr, 10);
+		if (exp < 1 || exp > __GRIDMAXEXP) {
+			fprintf(stderr, "--width takes an exponent in [1, %d]\n", __GRIDMAXEXP);
+			exit(EXIT_FAILURE);
+		}
+		width = 1U << exp;
+	} else {
+		size_t gridByte = __GRIDBYTE;
+		if (options.count("gridbyte") > 0) {
+			gridByte = 1L << strtol(options["gridbyte"].c_str(), nullptr, 10);
+		}
+		width = gridWidthChoose(vertices, edges, gridByte);
+	}
+
+	log("Grid width: " + std::to_string(width) + ", vertices: " + std::to_string(vertices) +
+		", edges: " + std::to_string(edges));
+	return width;
+}
+
+using MetaGrid = decltype(GridCSR::MetaData::grid)::GridInfo;
+
+// .ptr ends with the edge count, which an encoded .col does not tell by its size
+template <typename Index>
+static void ptrStat(FileView const & ptrFile, MetaGrid & g)
+{
+	auto ptr	 = (Index const *)ptrFile.addr;
+	g.count.edge = ptr[g.count.row];
+	g.max_row	 = 0;
+	for (size_t r = 0; r < g.count.row; r++) {
+		g.max_row = std::max(g.max_row, size_t(ptr[r + 1] - ptr[r]));
+	}
+}
+
+// file sizes, counts and the longest row of a written grid; the last one takes a pass over .ptr
+static void gridStat(fs::path const & folder, MetaGrid & g, bool const index)
+{
+	g.byte.row = fs::file_size(folder / fs::path(g.name + ".row"));
+	g.byte.ptr = fs::file_size(folder / fs::path(g.name + ".ptr"));
+	g.byte.col = fs::file_size(folder / fs::path(g.name + ".col"));
+	g.byte.idx = (index) ? fs::file_size(folder / fs::path(g.name + __ROWIDXEXT)) : 0;
+
+	g.count.row = g.byte.row / sizeof(V32);
+	g.ptr_bits	= 8 * g.byte.ptr / (g.count.row + 1);
+
+	auto ptrFile = fileMap(folder / fs::path(g.name + ".ptr"));
+	if (g.ptr_bits == 64) {
+		ptrStat<uint64_t>(*ptrFile, g);
+	} else {
+		ptrStat<V32>(*ptrFile, g);
+	}
+}
+
+void metaSave(fs::path const &	  folder,
+			  std::string const & name,
+			  uint32_t const	  width,
+			  uint64_t const	  maxVID,
+			  bool const		  compress,
+			  bool const		  index,
+			  std::string const & orientation,
+			  std::string const & transpose)
+{
+	GridCSR::MetaData meta;
+	meta.dataname	 = name;
+	meta.orientation = orientation;
+	meta.transpose	 = transpose;
+	meta.codec		 = (compress) ? GridCSR::COLCODEC : "";
+	std::tie(meta.extension.row, meta.extension.ptr, meta.extension.col) =
+		std::make_tuple(".row", ".ptr", ".col");
+	meta.extension.idx = (index) ? __ROWIDXEXT : "";
+
+	for (fs::directory_iterator iter(folder), end; iter != end; iter++) {
+		std::error_code ec;
+		if (iter->path().extension() != ".row" || fs::file_size(iter->path(), ec) == 0 || ec) {
+			continue;
+		}
+
+		MetaGrid   g;
+		ShardIndex sidx;
+		g.name = iter->path().stem().string();
+		if (!sidx.parse(g.name)) {
+			continue;
+		}
+
+		auto span	= sidx.span(width);
+		g.index.row = sidx.grid[0];
+		g.index.col = sidx.grid[1];
+		g.depth		= sidx.depth;
+		g.shard.row = sidx.shard[0];
+		g.shard.col = sidx.shard[1];
+		g.range.row = {g.index.row * width + span[0][0], g.index.row * width + span[0][1]};
+		g.range.col = {g.index.col * width + span[1][0], g.index.col * width + span[1][1]};
+		meta.grid.each.push_back(g);
+	}
+
+	std::sort(meta.grid.each.begin(),
+			  meta.grid.each.end(),
+			  [](MetaGrid const & l, MetaGrid const & r) {
+				  return std::tie(l.index.row, l.index.col, l.name) <
+						 std::tie(r.index.row, r.index.col, r.name);
+			  });
+
+	// readers take the grid list from here instead of scanning the folder
+	auto & each = meta.grid.each;
+	parallelDo(8, [&](size_t const i) {
+		for (size_t k = i; k < each.size(); k += 8) {
+			gridStat(folder, each[k], index);
+		}
+	});
+	meta.grid.detail = true;
+
+	meta.info.count.row = 0;
+	meta.info.count.col = 0;
+	for (auto & g : meta.grid.each) {
+		meta.info.count.row = std::max(meta.info.count.row, g.index.row + 1);
+		meta.info.count.col = std::max(meta.info.count.col, g.index.col + 1);
+	}
+
+	meta.info.width.row = width;
+	meta.info.width.col = width;
+
+	// unknown without Stage0 or maxVIDexp; the grids bound it then
+	meta.info.max_vid = (maxVID > 0) ? maxVID
+									 : std::max(meta.info.count.row, meta.info.count.col) * width - 1;
+
+	meta.Save(folder / __METAFILE);
+}
+
+void indexSave(fs::path const & folder, uint32_t const width)
+{
+	std::vector<fs::path> rows;
+	for (fs::directory_iterator iter(folder), end; iter != end; iter++) {
+		std::error_code ec;
+		if (iter->path().extension() != ".row" || fs::file_size(iter->path(), ec) == 0 || ec) {
+			continue;
+		}
+		rows.push_back(iter->path());
+	}
+
+	// a pass over .row only; rows are sorted, so the directory takes no sorting
+	parallelDo(8, [&](size_t const i) {
+		for (size_t k = i; k < rows.size(); k += 8) {
+			auto rowFile = fileMap(rows[k]);
+			auto count	 = rowFile->byte / sizeof(V32);
+
+			std::vector<uint8_t> idx(GridCSR::rowIndexByte(width, count));
+			GridCSR::rowIndexBuild((V32 const *)rowFile->addr, count, width, idx.data());
+
+			auto path	  = fs::path(rows[k]).replace_extension(__ROWIDXEXT);
+			auto partPath = fs::path(path.string() + __PARTEXT);
+
+			auto fp = open64(partPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+			assert_errno(fp >= 0);
+			fileWrite(fp, idx.data(), idx.size());
+			close(fp);
+			fileCommit(partPath, path);
+		}
+	});
+}
+
+void packSave(fs::path const & folder, std::string const & name, size_t const alignExp)
+{
+	GridCSR::MetaData meta;
+	meta.Load(folder / __METAFILE);
+
+	// the row index, when there is one, is the fourth segment of a grid
+	std::vector<std::string> ext = {meta.extension.row, meta.extension.ptr, meta.extension.col};
+	if (!meta.extension.idx.empty()) {
+		ext.push_back(meta.extension.idx);
+	}
+
+	auto packPath = folder / fs::path(name + __PACKEXT);
+
+	// a container committed before a crash only has its grid files left to remove
+	if (!fs::exists(packPath)) {
+		auto partPath = fs::path(packPath.string() + __PARTEXT);
+
+		GridCSR::PackWriter writer;
+		writer.init(partPath, 1UL << alignExp, ext.size());
+
+		auto & each = meta.grid.each;
+		parallelDo(8, [&](size_t const i) {
+			for (size_t k = i; k < each.size(); k += 8) {
+				std::array<sp<FileView>, 4> file;
+				std::array<void const *, 4> data;
+				std::array<size_t, 4>		byte;
+				for (size_t j = 0; j < ext.size(); j++) {
+					file[j] = fileMap(folder / fs::path(each[k].name + ext[j]));
+					data[j] = file[j]->addr;
+					byte[j] = file[j]->byte;
+				}
+				writer.put(each[k].name, data.data(), byte.data());
+			}
+		});
+
+		writer.close();
+		fileCommit(partPath, packPath);
+	}
+
+	// the metadata names the container before the grid files go, and is never seen half written
+	auto metaPart = folder / (std::string(__METAFILE) + __PARTEXT);
+	meta.pack	  = packPath.filename().string();
+	meta.Save(metaPart);
+	fileCommit(metaPart, folder / __METAFILE);
+
+	for (auto & g : meta.grid.each) {
+		for (auto & e : ext) {
+			fs::remove(folder / fs::path(g.name + e));
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef F586633D_8DD4_4B16_81DF_A4C0F437CCC9
+#define F586633D_8DD4_4B16_81DF_A4C0F437CCC9
+
+#include "type.h"
+
+#include <string>
+#include <unordered_map>
+
+#define __GRIDBYTE	 (1L << 28)	 // .col bytes a grid is sized for when the width is chosen
+#define __GRIDMINEXP 12
+#define __GRIDMAXEXP 24			 // local IDs stay within 24 bits, see __PACK24
+#define __METAFILE	 "meta.json" // GridCSR::MetaData of the output folder
+#define __PACKEXT	 ".gcsr"	 // GridCSR::Pack container of a whole dataset
+#define __ROWIDXEXT	 ".ridx"	 // GridCSR::RowIndex of a grid, next to its .row
+#define __TRANSPOSED "transpose" // dataset of the transposed grids, see --transpose
+
+// grid width and output metadata, see GridCSR::MetaData
+uint64_t inputEdges(fs::path const & inFolder);
+uint32_t gridWidthSelect(std::unordered_map<std::string, std::string> & options,
+						 uint64_t const								  vertices,
+						 uint64_t const								  edges);
+void	 metaSave(fs::path const &	  folder,
+				  std::string const & name,
+				  uint32_t const	  width,
+				  uint64_t const	  maxVID,
+				  bool const		  compress,
+				  bool const		  index,
+				  std::string const & orientation,
+				  std::string const & transpose);
+
+// writes the row index of every grid in the folder, see GridCSR/RowIndex.h
+void indexSave(fs::path const & folder, uint32_t const width);
+
+// moves every grid listed in the metadata into one GridCSR::Pack container, segments aligned to
+// 2^alignExp bytes, and removes the grid files
+void packSave(fs::path const & folder, std::string const & name, size_t const alignExp);
+
+#endif /* F586633D_8DD4_4B16_81DF_A4C0F437CCC9 */
@@ -0,0 +1,65 @@
+#ifndef E566FC70_56AB_4A98_B918_9972C16F221E
+#define E566FC70_56AB_4A98_B918_9972C16F221E
+
+#include "type.h"
+#include "util.h"
+
+#include <array>
+#include <vector>
+
+#define __TEXTBLOCK (1L << 20) // 1MB of text lines per mapper job
+
+// Input files are told apart by their extension, anything unknown is Adj6.
+// A text edge list has one "src dst" pair per line, the two IDs separated by spaces, tabs or
+// commas, so TSV, CSV and SNAP files read alike. Further columns such as weights are ignored, and
+// so are lines that do not start with an ID, such as comments or a CSV header; a line that starts
+// with one but is no edge stops the conversion. Matrix Market coordinate files are text edge lists
+// with 1-based IDs behind a size line; a symmetric one stores a single triangle, and its edges are
+// read in both directions.
+enum class InputFormat { Adj6, EdgeList, MatrixMarket };
+
+InputFormat inputFormat(fs::path const & path);
+
+// [begin, end) blocks of whole Adj6 rows or whole text lines; an Adj6 file gets its block index
+// saved below outFolder, see splitAdj6()
+sp<bchan<RowBlock>> splitInput(sp<FileView> in, fs::path const & outFolder);
+
+// (src, dst) pairs of a block of text lines, with 0-based IDs
+void textDecode(FileView const &					  text,
+				RowBlock const &					  blk,
+				InputFormat const					  format,
+				std::vector<std::array<uint64_t, 2>> & out);
+
+// per-thread scratch of forEachInputRow()
+struct InputBuffer {
+	std::vector<uint64_t>				  dst;
+	std::vector<std::array<uint64_t, 2>> edges;
+};
+
+// calls func(uint64_t src, uint64_t const * dst, size_t cnt) for every row of blk; in a text edge
+// list every run of lines with the same source makes one row
+template <typename Func>
+void forEachInputRow(FileView const & in, RowBlock const & blk, InputBuffer & buf, Func func)
+{
+	auto format = inputFormat(in.path);
+
+	if (format == InputFormat::Adj6) {
+		forEachRow(in, blk, [&](RowPos const & row) {
+			buf.dst.resize(row.cnt);
+			be6_le8_bulk(&in.addr[row.dstStart], buf.dst.data(), row.cnt);
+			func(uint64_t(row.src), (uint64_t const *)buf.dst.data(), size_t(row.cnt));
+		});
+		return;
+	}
+
+	textDecode(in, blk, format, buf.edges);
+	for (size_t i = 0, j = 0; i < buf.edges.size(); i = j) {
+		buf.dst.resize(0);
+		for (j = i; j < buf.edges.size() && buf.edges[j][0] == buf.edges[i][0]; j++) {
+			buf.dst.push_back(buf.edges[j][1]);
+		}
+		func(buf.edges[i][0], (uint64_t const *)buf.dst.data(), buf.dst.size());
+	}
+}
+
+#endif /* E566FC70_56AB_4A98_B918_9972C16F221E */
@@ -1,3 +1,7 @@
+#include "dataset.h"
+#include "manifest.h"
+#include "order.h"
+#include "relabel.h"
 #include "stage.h"
 #include "util.h"
 
@@ -5,23 +9,86 @@
 #include <string>
 #include <thread>
 
+static void printOrderings()
+{
+	fprintf(stderr, "relabelType:\n");
+	for (auto & o : orderings()) {
+		fprintf(stderr, "  %ld, %s: %s\n", o.relabelType, o.name, o.description);
+	}
+}
+
+// relabelType by number or by ordering name, 0 for none
+static uint64_t parseRelabelType(char const * arg)
+{
+	if (std::string(arg) == "0") {
+		return 0;
+	}
+
+	auto ordering = orderingFind(arg);
+	if (ordering == nullptr) {
+		fprintf(stderr, "unknown relabelType: %s\n", arg);
+		printOrderings();
+		exit(EXIT_FAILURE);
+	}
+	return ordering->relabelType;
+}
+
 int main(int argc, char * argv[])
 {
 	// Variables
-	fs::path inFolder, outFolder;
-	bool	 lowerTriangular = false;
-	uint64_t maxVID			 = 0;
-	uint64_t relabelType	 = 0;
-	size_t	 limitByte		 = 1L << 30;
+	fs::path	inFolder, outFolder;
+	std::string outName;
+	bool		lowerTriangular = false;
+	uint64_t	maxVID			= 0;
+	uint64_t	relabelType		= 0;
+	uint32_t	gridWidth		= 0;
+	size_t		limitByte		= 1L << 30;
+	bool		balanced		= false;
+	size_t		packExp			= 0; // segment alignment of a --pack container, 0 for none
+	bool		compress		= false; // .col files encoded as in GridCSR/Codec.h
+	bool		index			= false; // a GridCSR/RowIndex.h file next to each .row
+	bool		symmetric		= false; // both directions of every edge in the grids
+	bool		transpose		= false; // the transposed grids too, a dataset below the output
 
 	// Parse argument
+	auto options = parseOptions(argc, argv);
+
+	compress = (options.count("compress") > 0);
+	index	 = (options.count("index") > 0);
+
+	// a symmetric dataset is its own transpose
+	symmetric = (options.count("symmetric") > 0);
+	transpose = (options.count("transpose") > 0);
+	if (symmetric && transpose) {
+		fprintf(stderr, "--symmetric grids are their own transpose, leave out --transpose\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (options.count("pack") > 0) {
+		packExp = options["pack"].empty() ? 12 : strtol(options["pack"].c_str(), nullptr, 10);
+		if (packExp < 12 || packExp > 30) {
+			fprintf(stderr, "--pack takes an alignment exponent in [12, 30]\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if (options.count("split") > 0) {
+		if (options["split"] == "balanced") {
+			balanced = true;
+		} else if (options["split"] != "midpoint") {
+			fprintf(stderr, "unknown split: %s\n", options["split"].c_str());
+			exit(EXIT_FAILURE);
+		}
+	}
+
 	switch (argc) {
 	case 8:
 		maxVID		= (1L << strtol(argv[6], nullptr, 10));
-		relabelType = strtol(argv[7], nullptr, 10);
+		relabelType = parseRelabelType(argv[7]);
 	case 6:
 		inFolder  = fs::absolute(fs::path(std::string(argv[1])));
-		outFolder = fs::absolute(fs::path(std::string(argv[2]))) / fs::path(std::string(argv[3]));
+		outName	  = std::string(argv[3]);
+		outFolder = fs::absolute(fs::path(std::string(argv[2]))) / fs::path(outName);
 		lowerTriangular = (strtol(argv[4], nullptr, 10) != 0);
 		limitByte		= (1L << strtol(argv[5], nullptr, 10));
 		break;
@@ -30,21 +97,39 @@ int main(int argc, char * argv[])
 				"usage: \n"
 				"%s <inFolder> <outFolder> <outName> <LowerTriangular> <limitExp>\n"
 				"%s <inFolder> <outFolder> <outName> <LowerTriangular> <limitExp> <maxVIDexp> "
-				"<relabelType> \n",
+				"<relabelType> \n"
+				"inFolder holds Adj6 files or text edge lists, told apart by extension:\n"
+				"  .tsv .csv .txt .el .edges (one \"src dst\" per line), .mtx (Matrix Market)\n"
+				"options:\n"
+				"  --relabel=<relabel.fwd>  relabel with a table saved by an earlier Stage0\n"
+				"  --width=<exp>            grid width 2^exp instead of choosing one\n"
+				"  --gridbyte=<exp>         choose the grid width for 2^exp bytes of .col per grid\n"
+				"  --resume                 continue an interrupted run from its manifest\n"
+				"  --split=<mode>           Stage3 split, midpoint (default) or balanced: cut at the\n"
+				"                           edge-count median, shard names carry their ranges\n"
+				"  --pack[=<exp>]           put all grids into one <outName>.gcsr container with\n"
+				"                           segments aligned to 2^exp bytes (12: 4KB, 21: 2MB)\n"
+				"  --compress               delta and StreamVByte coded .col files, 2-4x smaller\n"
+				"  --index                  a row index per grid, so engines skip the dense lookup\n"
+				"  --transpose              the transposed grids too, written in the same pass to the\n"
+				"                           dataset <outFolder>/<outName>/transpose\n"
+				"  --symmetric              both directions of every edge, the full adjacency matrix\n",
 				argv[0],
 				argv[0]);
+		printOrderings();
 		exit(EXIT_FAILURE);
 	}
 
 	fprintf(stdout,
 			"inFolder=%s, outFolder=%s, lowerTriangular=%s, maxVID=%ld, relabelType=%ld, "
-			"limitByte=%ld\n",
+			"limitByte=%ld, split=%s\n",
 			inFolder.c_str(),
 			outFolder.c_str(),
 			(lowerTriangular) ? "true" : "false",
 			maxVID,
 			relabelType,
-			limitByte);
+			limitByte,
+			(balanced) ? "balanced" : "midpoint");
 
 	// Create output folder
 	if (!fs::exists(outFolder)) {
@@ -54,26 +139,161 @@ int main(int argc, char * argv[])
 		}
 	}
 
+	// completed work; --resume skips it
+	Manifest manifest;
+	manifest.init(outFolder, options.count("resume") > 0);
+
 	// Start procedure
 	stopwatch("Total Procedure", [&] {
-		sp<std::vector<uint64_t>> relabelTable;
-		if (relabelType > 0) {
+		sp<RelabelTable> relabelTable;
+		if (options.count("relabel") > 0) {
+			auto fwdPath = fs::absolute(fs::path(options["relabel"]));
+			relabelTable = relabelLoad(fwdPath);
+			relabelType	 = relabelTable->relabelType;
+			relabelLink(fwdPath, outFolder);
+			log("Stage0 skipped, relabel table: " + std::string(fwdPath));
+		} else if (relabelType > 0 && manifest.done("Stage0")) {
+			relabelTable = relabelLoad(outFolder / fs::path(__RELABELFWD));
+			log("Stage0 resumed, relabel table: " + std::string(outFolder / __RELABELFWD));
+		} else if (relabelType > 0) {
 			stopwatch("Stage0",
 					  [&] { relabelTable = stage0(inFolder, outFolder, maxVID, relabelType); });
+			manifest.finish("Stage0");
+		}
+
+		if (relabelTable) {
+			maxVID = relabelTable->size - 1;
+		}
+
+		// a resumed run keeps the width its grids were cut with
+		auto widths = manifest.items("width");
+		if (!widths.empty()) {
+			gridWidth = std::stoul(widths.front());
+			log("grid width resumed: " + widths.front());
+		} else {
+			// exact counts when there is a relabel table, bounds otherwise
+			if (relabelTable && relabelTable->edges > 0) {
+				gridWidth = gridWidthSelect(options, relabelTable->active, relabelTable->edges);
+			} else {
+				auto vertices = (maxVID > 0) ? maxVID + 1 : (1UL << 32);
+				gridWidth	  = gridWidthSelect(options, vertices, inputEdges(inFolder));
+			}
+			manifest.finish("width", std::to_string(gridWidth));
+		}
+
+		// a resumed run writes its .col files the way it started
+		auto compressed = manifest.items("compress");
+		if (!compressed.empty()) {
+			compress = (compressed.front() == "1");
+		} else {
+			manifest.finish("compress", (compress) ? "1" : "0");
+		}
+
+		// and so do its row indexes
+		auto indexed = manifest.items("index");
+		if (!indexed.empty()) {
+			index = (indexed.front() == "1");
+		} else {
+			manifest.finish("index", (index) ? "1" : "0");
+		}
+
+		// and emits the orientations it started with
+		auto orients = manifest.items("orient");
+		if (!orients.empty()) {
+			symmetric = (orients.front() == "symmetric");
+			transpose = (orients.front() == "transpose");
+		} else {
+			auto orient = (symmetric) ? "symmetric" : (transpose) ? "transpose" : "plain";
+			manifest.finish("orient", orient);
 		}
-		stopwatch("Stage1", [&] {
-			stage1(
-				inFolder, outFolder, (1L << 24), lowerTriangular, (relabelType > 0), relabelTable);
+
+		// what the grids hold, for the metadata; the transposed grids of lower ones are upper
+		auto orientation = (symmetric) ? "symmetric" : (lowerTriangular) ? "lower" : "plain";
+		auto transposed	 = (lowerTriangular) ? "upper" : "plain";
+
+		// the transposed grids are a dataset of their own, with a manifest of its own
+		auto		 transposeFolder = (transpose) ? outFolder / __TRANSPOSED : fs::path();
+		sp<Manifest> transposeManifest;
+		if (transpose) {
+			if (options.count("resume") == 0) {
+				fs::remove_all(transposeFolder);
+			}
+			fs::create_directories(transposeFolder);
+			transposeManifest = makeSp<Manifest>();
+			transposeManifest->init(transposeFolder, options.count("resume") > 0);
+		}
+
+		// a stage is only marked when all of it is done; its items are marked on their own
+		auto stageIn = [&](Manifest & m, std::string const & name, std::function<void()> func) {
+			if (m.done(name)) {
+				log(name + " resumed, already done");
+				return;
+			}
+			stopwatch(name, func);
+			m.finish(name);
+		};
+		auto stage = [&](std::string const & name, std::function<void()> func) {
+			stageIn(manifest, name, func);
+		};
+
+		stage("Stage1", [&] {
+			stage1(inFolder,
+				   outFolder,
+				   gridWidth,
+				   lowerTriangular,
+				   (relabelType > 0),
+				   relabelTable,
+				   symmetric,
+				   transposeFolder);
 		});
 
-		stopwatch("Stage2", [&] { stage2(outFolder); });
-		stopwatch("Stage3", [&] { stage3(outFolder, (1 << 24), limitByte); });
-		stopwatch("Stage4", [&] { stage4(outFolder); });
+		// the transposed dataset is finished first; the output's stages list the .el32 files below
+		// the output recursively, and its metadata names the transposed dataset
+		if (transpose) {
+			auto & m = *transposeManifest;
+			stageIn(m, "Stage2", [&] { stage2(transposeFolder, m); });
+			stageIn(m, "Stage3", [&] {
+				stage3(transposeFolder, gridWidth, limitByte, balanced, m);
+			});
+			stageIn(m, "Stage4", [&] { stage4(transposeFolder, compress, m); });
+			if (index) {
+				stageIn(m, "Index", [&] { indexSave(transposeFolder, gridWidth); });
+			}
+			stageIn(m, "Meta", [&] {
+				metaSave(
+					transposeFolder, outName, gridWidth, maxVID, compress, index, transposed, "..");
+			});
+			if (packExp > 0) {
+				stageIn(m, "Pack", [&] { packSave(transposeFolder, outName, packExp); });
+			}
+		}
+
+		stage("Stage2", [&] { stage2(outFolder, manifest); });
+		stage("Stage3", [&] { stage3(outFolder, gridWidth, limitByte, balanced, manifest); });
+		stage("Stage4", [&] { stage4(outFolder, compress, manifest); });
+
+		if (index) {
+			stage("Index", [&] { indexSave(outFolder, gridWidth); });
+		}
+		stage("Meta", [&] {
+			metaSave(outFolder,
+					 outName,
+					 gridWidth,
+					 maxVID,
+					 compress,
+					 index,
+					 orientation,
+					 (transpose) ? __TRANSPOSED : "");
+		});
+		if (packExp > 0) {
+			stage("Pack", [&] { packSave(outFolder, outName, packExp); });
+		}
 	});
 
 	// Finish procedure
 	log(std::string(inFolder) + "->" + std::string(outFolder) +
-		", relabel type: " + std::to_string(relabelType) + ", completed");
+		", relabel type: " + std::to_string(relabelType) + ", grid width: " +
+		std::to_string(gridWidth) + ", completed");
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "manifest.h"
+#include "util.h"
+
+#include <unistd.h>
+
+void Manifest::init(fs::path const & folder, bool const resume)
+{
+	auto path = folder / fs::path(__MANIFEST);
+
+	if (resume && fs::exists(path)) {
+		auto   text = fileLoad<char>(path);
+		size_t pos	= 0;
+		for (size_t i = 0; i < text->size(); i++) {
+			if ((*text)[i] == '\n') {
+				this->entries.insert(std::string(&(*text)[pos], i - pos));
+				pos = i + 1;
+			}
+		}
+
+		// drop a line torn by the crash, so the next one starts clean
+		if (pos < text->size()) {
+			assert_errno(truncate(path.c_str(), pos) == 0);
+		}
+		log("Manifest: resuming with " + std::to_string(this->entries.size()) + " entries");
+	}
+
+	auto flags	   = O_CREAT | O_APPEND | O_WRONLY | (resume ? 0 : O_TRUNC);
+	this->folderFd = open64(folder.c_str(), O_RDONLY | O_DIRECTORY);
+	this->logFd	   = open64(path.c_str(), flags, 0644);
+	assert_errno(this->folderFd >= 0 && this->logFd >= 0);
+}
+
+Manifest::~Manifest() noexcept
+{
+	close(this->logFd);
+	close(this->folderFd);
+}
+
+bool Manifest::done(std::string const & stage, std::string const & item)
+{
+	std::lock_guard<std::mutex> lg(this->lock);
+	return this->entries.count(stage + " " + item) > 0;
+}
+
+void Manifest::finish(std::string const & stage, std::string const & item)
+{
+	auto line = stage + " " + item;
+
+	std::lock_guard<std::mutex> lg(this->lock);
+
+	// the renames and removals before this point, or everything written for a whole stage
+	if (item.empty()) {
+		assert_errno(syncfs(this->folderFd) == 0);
+	} else {
+		assert_errno(fsync(this->folderFd) == 0);
+	}
+
+	fileWrite(this->logFd, (line + "\n").c_str(), line.size() + 1);
+	assert_errno(fdatasync(this->logFd) == 0);
+	this->entries.insert(line);
+}
+
+std::vector<std::string> Manifest::items(std::string const & stage)
+{
+	std::lock_guard<std::mutex> lg(this->lock);
+
+	std::vector<std::string> out;
+	for (auto & e : this->entries) {
+		if (e.compare(0, stage.size() + 1, stage + " ") == 0) {
+			out.push_back(e.substr(stage.size() + 1));
+		}
+	}
+	return out;
+}
+
+void fileSync(fs::path const & path)
+{
+	auto fp = open64(path.c_str(), O_RDONLY);
+	assert_errno(fp >= 0);
+	assert_errno(fsync(fp) == 0);
+	close(fp);
+}
+
+void fileCommit(fs::path const & from, fs::path const & to)
+{
+	fileSync(from);
+	fs::rename(from, to);
+}
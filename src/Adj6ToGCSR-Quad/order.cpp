@@ -0,0 +1,472 @@
+#include "order.h"
+#include "util.h"
+
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <thread>
+
+#define __RANKDENSE	 (1 << 16) // degrees counted in dense buckets; the rest are sorted hubs
+#define __GATHERGRAIN 1024	   // items per gather block, at least
+
+// Calls func(i, out) for every i in [0, count), in parallel blocks; out is the block's own vector
+// and the blocks are concatenated in order, so the result is as if i ran from 0 to count.
+template <typename Func>
+static std::vector<uint32_t> gather(size_t const count, Func func)
+{
+	size_t const blocks	  = std::max(size_t(1),
+									 std::min(size_t(std::thread::hardware_concurrency()),
+											  ceil(count, __GATHERGRAIN)));
+	auto		 blockPos = [&](size_t const b) { return count * b / blocks; };
+
+	std::vector<std::vector<uint32_t>> part(blocks);
+	auto							   run = [&](size_t const b) {
+		  for (auto i = blockPos(b); i < blockPos(b + 1); i++) {
+			  func(i, part[b]);
+		  }
+	};
+
+	// small rounds are common in the level-synchronous orderings, keep them off the pool
+	if (blocks == 1) {
+		run(0);
+		return std::move(part[0]);
+	}
+	tbb::parallel_for(size_t(0), blocks, run);
+
+	std::vector<uint32_t> out;
+	for (auto & p : part) {
+		out.insert(out.end(), p.begin(), p.end());
+	}
+	return out;
+}
+
+// relabel table from the new order of the vertices that have neighbors; the rest follow by ID
+static sp<std::vector<uint64_t>> fromSequence(std::vector<uint32_t> const & seq,
+											  Degree const &				degree)
+{
+	auto out = makeSp<std::vector<uint64_t>>(degree.size());
+	tbb::parallel_for(size_t(0), seq.size(), [&](size_t const i) { (*out)[seq[i]] = i; });
+
+	auto zero = gather(degree.size(), [&](size_t const v, std::vector<uint32_t> & o) {
+		if (degree[v].load(std::memory_order_relaxed) == 0) {
+			o.push_back(v);
+		}
+	});
+	tbb::parallel_for(
+		size_t(0), zero.size(), [&](size_t const i) { (*out)[zero[i]] = seq.size() + i; });
+
+	return out;
+}
+
+// Relabel table ordered by degree; counting sort, no comparison sort.
+// relabelType 1: ascending degree, ties by ascending ID, zero-degree vertices last
+// relabelType 2: descending degree, ties by descending ID
+// Degrees below __RANKDENSE are bucketed with per-block histograms; the rare hubs above it are
+// few enough to sort directly and take their slot in the bucket order.
+static sp<std::vector<uint64_t>> rankByDegree(Degree const & degree, uint64_t const relabelType)
+{
+	bool const ascending = (relabelType == 1);
+
+	size_t const blocks	  = std::max(1U, std::thread::hardware_concurrency());
+	auto		 blockPos = [&](size_t const b) { return degree.size() * b / blocks; };
+
+	std::vector<std::vector<uint64_t>> hist(blocks);
+	std::vector<std::vector<uint64_t>> hubs(blocks);
+	parallelDo(blocks, [&](size_t const b) {
+		hist[b].resize(__RANKDENSE, 0);
+		for (auto v = blockPos(b); v < blockPos(b + 1); v++) {
+			auto d = degree[v].load(std::memory_order_relaxed);
+			if (d < __RANKDENSE) {
+				hist[b][d]++;
+			} else {
+				hubs[b].push_back(v);
+			}
+		}
+	});
+
+	std::vector<uint64_t> hub;
+	for (auto & h : hubs) {
+		hub.insert(hub.end(), h.begin(), h.end());
+	}
+	std::sort(hub.begin(), hub.end(), [&](uint64_t const l, uint64_t const r) {
+		auto dl = degree[l].load(std::memory_order_relaxed);
+		auto dr = degree[r].load(std::memory_order_relaxed);
+		if (dl == dr) {
+			return (ascending) ? l < r : l > r;
+		} else {
+			return (ascending) ? dl < dr : dl > dr;
+		}
+	});
+
+	// bucket order, with __RANKDENSE standing in for the hubs
+	std::vector<uint32_t> order;
+	if (ascending) {
+		for (uint32_t d = 1; d <= __RANKDENSE; d++) {
+			order.push_back(d);
+		}
+		order.push_back(0);
+	} else {
+		for (uint32_t d = __RANKDENSE; d > 0; d--) {
+			order.push_back(d);
+		}
+		order.push_back(0);
+	}
+
+	// turn the histograms into first positions; blocks in ID order keep ties stable
+	uint64_t pos = 0, hubPos = 0;
+	for (auto d : order) {
+		if (d == __RANKDENSE) {
+			hubPos = pos;
+			pos += hub.size();
+			continue;
+		}
+
+		for (size_t i = 0; i < blocks; i++) {
+			auto b	   = (ascending) ? i : blocks - 1 - i;
+			auto c	   = hist[b][d];
+			hist[b][d] = pos;
+			pos += c;
+		}
+	}
+
+	auto out = makeSp<std::vector<uint64_t>>(degree.size());
+	parallelDo(blocks, [&](size_t const b) {
+		for (auto i = blockPos(b); i < blockPos(b + 1); i++) {
+			auto v = (ascending) ? i : blockPos(b + 1) - 1 - (i - blockPos(b));
+			auto d = degree[v].load(std::memory_order_relaxed);
+			if (d < __RANKDENSE) {
+				(*out)[v] = hist[b][d]++;
+			}
+		}
+	});
+
+	for (size_t i = 0; i < hub.size(); i++) {
+		(*out)[hub[i]] = hubPos + i;
+	}
+
+	return out;
+}
+
+// Degeneracy (k-core) ordering: vertices in the order they are peeled, lowest core first.
+// Peeling is level-synchronous: every round removes all vertices left with at most k neighbors
+// at once and decrements their neighbors in parallel; a round's vertices are placed by ID.
+static std::vector<uint32_t> degeneracy(Degree const & degree, Adjacency const & adj)
+{
+	auto const n = degree.size();
+
+	std::vector<std::atomic<uint32_t>> left(n);
+	std::vector<uint8_t>			   removed(n, 0);
+	tbb::parallel_for(size_t(0), n, [&](size_t const v) {
+		left[v].store(degree[v].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	});
+
+	auto rest = gather(n, [&](size_t const v, std::vector<uint32_t> & o) {
+		if (degree[v].load(std::memory_order_relaxed) > 0) {
+			o.push_back(v);
+		}
+	});
+
+	std::vector<uint32_t> seq;
+	seq.reserve(rest.size());
+
+	while (!rest.empty()) {
+		// everything at or below the previous k is gone, so this only moves up
+		uint32_t const k = tbb::parallel_reduce(
+			tbb::blocked_range<size_t>(0, rest.size()),
+			UINT32_MAX,
+			[&](tbb::blocked_range<size_t> const & r, uint32_t m) {
+				for (auto i = r.begin(); i < r.end(); i++) {
+					m = std::min(m, left[rest[i]].load(std::memory_order_relaxed));
+				}
+				return m;
+			},
+			[](uint32_t const l, uint32_t const r) { return std::min(l, r); });
+
+		auto frontier = gather(rest.size(), [&](size_t const i, std::vector<uint32_t> & o) {
+			if (left[rest[i]].load(std::memory_order_relaxed) <= k) {
+				o.push_back(rest[i]);
+			}
+		});
+
+		while (!frontier.empty()) {
+			seq.insert(seq.end(), frontier.begin(), frontier.end());
+			tbb::parallel_for(size_t(0), frontier.size(), [&](size_t const i) {
+				removed[frontier[i]] = 1;
+			});
+
+			// a neighbor joins the next round when this round brings it down to k, exactly once
+			auto next = gather(frontier.size(), [&](size_t const i, std::vector<uint32_t> & o) {
+				auto v = frontier[i];
+				for (auto e = adj.ptr[v]; e < adj.ptr[v + 1]; e++) {
+					auto u = adj.col[e];
+					if (removed[u]) {
+						continue;
+					}
+
+					auto c = left[u].load(std::memory_order_relaxed);
+					while (c > k && !left[u].compare_exchange_weak(c, c - 1)) {
+					}
+					if (c == k + 1) {
+						o.push_back(u);
+					}
+				}
+			});
+			std::sort(next.begin(), next.end());
+			frontier = std::move(next);
+		}
+
+		rest = gather(rest.size(), [&](size_t const i, std::vector<uint32_t> & o) {
+			if (!removed[rest[i]]) {
+				o.push_back(rest[i]);
+			}
+		});
+	}
+
+	return seq;
+}
+
+// Cuthill-McKee: breadth first from the lowest-degree unvisited vertex of each component, the
+// children of every vertex placed by ascending degree. Levels are expanded in parallel; a child
+// reached from several parents belongs to the first of them in the level, as in the serial order.
+static std::vector<uint32_t> cuthillMcKee(Degree const & degree, Adjacency const & adj)
+{
+	auto const n = degree.size();
+
+	auto deg = [&](uint32_t const v) { return degree[v].load(std::memory_order_relaxed); };
+
+	// start candidates: vertices with neighbors by ascending degree, then ID
+	auto byDegree = rankByDegree(degree, 1);
+	auto nonzero  = gather(n, [&](size_t const v, std::vector<uint32_t> & o) {
+		 if (deg(v) > 0) {
+			 o.push_back(v);
+		 }
+	 });
+	std::vector<uint32_t> start(nonzero.size());
+	tbb::parallel_for(size_t(0), nonzero.size(), [&](size_t const i) {
+		start[(*byDegree)[nonzero[i]]] = nonzero[i];
+	});
+	byDegree.reset();
+
+	std::vector<std::atomic<uint32_t>> owner(n);
+	std::vector<uint8_t>			   visited(n, 0);
+
+	std::vector<uint32_t> seq;
+	seq.reserve(nonzero.size());
+
+	size_t next = 0;
+	while (seq.size() < nonzero.size()) {
+		while (visited[start[next]]) {
+			next++;
+		}
+
+		std::vector<uint32_t> frontier = {start[next]};
+		visited[start[next]]		   = 1;
+
+		while (!frontier.empty()) {
+			seq.insert(seq.end(), frontier.begin(), frontier.end());
+
+			// every unvisited neighbor ends up owned by the lowest parent index reaching it
+			gather(frontier.size(), [&](size_t const i, std::vector<uint32_t> &) {
+				auto v = frontier[i];
+				for (auto e = adj.ptr[v]; e < adj.ptr[v + 1]; e++) {
+					if (!visited[adj.col[e]]) {
+						owner[adj.col[e]].store(UINT32_MAX, std::memory_order_relaxed);
+					}
+				}
+			});
+			gather(frontier.size(), [&](size_t const i, std::vector<uint32_t> &) {
+				auto v = frontier[i];
+				for (auto e = adj.ptr[v]; e < adj.ptr[v + 1]; e++) {
+					auto u = adj.col[e];
+					if (visited[u]) {
+						continue;
+					}
+
+					auto c = owner[u].load(std::memory_order_relaxed);
+					while (i < c && !owner[u].compare_exchange_weak(c, i)) {
+					}
+				}
+			});
+
+			auto children = gather(frontier.size(), [&](size_t const i, std::vector<uint32_t> & o) {
+				auto v	   = frontier[i];
+				auto first = o.size();
+				for (auto e = adj.ptr[v]; e < adj.ptr[v + 1]; e++) {
+					auto u = adj.col[e];
+					if (!visited[u] && owner[u].load(std::memory_order_relaxed) == i) {
+						o.push_back(u);
+					}
+				}
+
+				std::sort(o.begin() + first, o.end(), [&](uint32_t const l, uint32_t const r) {
+					return (deg(l) == deg(r)) ? l < r : deg(l) < deg(r);
+				});
+				o.erase(std::unique(o.begin() + first, o.end()), o.end());
+			});
+
+			tbb::parallel_for(
+				size_t(0), children.size(), [&](size_t const i) { visited[children[i]] = 1; });
+			frontier = std::move(children);
+		}
+	}
+
+	return seq;
+}
+
+// Reverse Cuthill-McKee, the usual bandwidth-reducing order
+static std::vector<uint32_t> reverseCuthillMcKee(Degree const & degree, Adjacency const & adj)
+{
+	auto seq = cuthillMcKee(degree, adj);
+	std::reverse(seq.begin(), seq.end());
+	return seq;
+}
+
+// Gorder-style greedy ordering: the next vertex is the one sharing the most neighbors with, or
+// adjacent to, the last __GORDERWIN placed vertices. The RCM order is cut into partitions that
+// are ordered independently in parallel; inside one, vertices with no overlap follow RCM order.
+static std::vector<uint32_t> gorder(Degree const & degree, Adjacency const & adj)
+{
+	auto const n   = degree.size();
+	auto const seq = reverseCuthillMcKee(degree, adj);
+	auto const m   = seq.size();
+
+	auto deg = [&](uint32_t const v) { return degree[v].load(std::memory_order_relaxed); };
+
+	std::vector<uint32_t> rank(n, UINT32_MAX);
+	tbb::parallel_for(size_t(0), m, [&](size_t const i) { rank[seq[i]] = i; });
+
+	size_t const workers  = std::max(1U, std::thread::hardware_concurrency());
+	size_t const parts	  = std::max(workers * 4, ceil(m, __GORDERPART));
+	size_t const partSize = std::max(size_t(1), ceil(m, parts));
+
+	// partitions touch disjoint entries only
+	std::vector<uint32_t> score(n, 0);
+	std::vector<uint8_t>  placed(n, 0);
+	std::vector<uint32_t> out(m);
+
+	tbb::parallel_for(size_t(0), ceil(m, partSize), [&](size_t const p) {
+		auto lo = p * partSize;
+		auto hi = std::min(m, lo + partSize);
+
+		auto open = [&](uint32_t const u) { return rank[u] >= lo && rank[u] < hi && !placed[u]; };
+
+		// max-heap on (score, earlier in RCM); entries are never below the live score and stale
+		// ones are refreshed when they surface
+		using Entry = std::pair<uint32_t, uint32_t>;
+		std::priority_queue<Entry> heap;
+
+		auto bump = [&](uint32_t const u, int const delta) {
+			score[u] += delta;
+			if (delta > 0) {
+				heap.push({score[u], UINT32_MAX - rank[u]});
+			}
+		};
+
+		// v entering (+1) or leaving (-1) the window: its neighbors and their neighbors
+		auto update = [&](uint32_t const v, int const delta) {
+			for (auto e = adj.ptr[v]; e < adj.ptr[v + 1]; e++) {
+				auto u = adj.col[e];
+				if (open(u)) {
+					bump(u, delta);
+				}
+				if (deg(u) > __GORDERHUB) {
+					continue;
+				}
+				for (auto f = adj.ptr[u]; f < adj.ptr[u + 1]; f++) {
+					auto x = adj.col[f];
+					if (x != v && open(x)) {
+						bump(x, delta);
+					}
+				}
+			}
+		};
+
+		std::deque<uint32_t> window;
+		size_t				 scan = lo;
+		for (auto i = lo; i < hi; i++) {
+			uint32_t v = UINT32_MAX;
+			while (!heap.empty()) {
+				auto top = heap.top();
+				auto u	 = seq[UINT32_MAX - top.second];
+				if (placed[u] || top.first != score[u]) {
+					heap.pop();
+					if (!placed[u] && top.first > score[u] && score[u] > 0) {
+						heap.push({score[u], top.second});
+					}
+					continue;
+				}
+				v = u;
+				break;
+			}
+
+			if (v == UINT32_MAX) {
+				while (placed[seq[scan]]) {
+					scan++;
+				}
+				v = seq[scan];
+			}
+
+			placed[v] = 1;
+			out[i]	  = v;
+
+			window.push_back(v);
+			update(v, 1);
+			if (window.size() > __GORDERWIN) {
+				update(window.front(), -1);
+				window.pop_front();
+			}
+		}
+	});
+
+	return out;
+}
+
+std::vector<Ordering> const & orderings()
+{
+	static std::vector<Ordering> const list = {
+		{1,
+		 "degree-asc",
+		 "ascending degree",
+		 false,
+		 [](Degree const & degree, Adjacency const *) { return rankByDegree(degree, 1); }},
+		{2,
+		 "degree-desc",
+		 "descending degree",
+		 false,
+		 [](Degree const & degree, Adjacency const *) { return rankByDegree(degree, 2); }},
+		{3,
+		 "degeneracy",
+		 "k-core peeling order, lowest core first",
+		 true,
+		 [](Degree const & degree, Adjacency const * adj) {
+			 return fromSequence(degeneracy(degree, *adj), degree);
+		 }},
+		{4,
+		 "rcm",
+		 "reverse Cuthill-McKee, breadth first by component",
+		 true,
+		 [](Degree const & degree, Adjacency const * adj) {
+			 return fromSequence(reverseCuthillMcKee(degree, *adj), degree);
+		 }},
+		{5,
+		 "gorder",
+		 "greedy neighbor overlap over a sliding window",
+		 true,
+		 [](Degree const & degree, Adjacency const * adj) {
+			 return fromSequence(gorder(degree, *adj), degree);
+		 }},
+	};
+	return list;
+}
+
+Ordering const * orderingFind(std::string const & key)
+{
+	for (auto & o : orderings()) {
+		if (key == o.name || key == std::to_string(o.relabelType)) {
+			return &o;
+		}
+	}
+	return nullptr;
+}
@@ -0,0 +1,102 @@
+#include "relabel.h"
+#include "util.h"
+
+#include <algorithm>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+static uint64_t const __RELABEL_MAGIC	= 0x326c6562616c6552; // "Relabel2"
+static uint64_t const __RELABEL1_MAGIC = 0x316c6562616c6552; // "Relabel1", no active and edges
+
+static void relabelWrite(fs::path const & path, RelabelHeader const & header, uint64_t const * map)
+{
+	auto tmpPath = fs::path(path.string() + ".tmp");
+
+	auto fp = open64(tmpPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	assert_errno(fp >= 0);
+	fileWrite(fp, &header, sizeof(header));
+	fileWrite(fp, map, header.vertices * sizeof(uint64_t));
+	close(fp);
+
+	fs::rename(tmpPath, path);
+}
+
+// header carries relabelType, active and edges; the rest is filled in here
+void relabelSave(fs::path const & folder, std::vector<uint64_t> const & fwd, RelabelHeader header)
+{
+	header.magic	= __RELABEL_MAGIC;
+	header.vertices = fwd.size();
+	header.inverse	= 0;
+	relabelWrite(folder / __RELABELFWD, header, fwd.data());
+
+	std::vector<uint64_t> inv(fwd.size());
+
+	auto workers = std::thread::hardware_concurrency();
+	parallelDo(workers, [&](size_t const idx) {
+		for (auto i = idx; i < fwd.size(); i += workers) {
+			inv[fwd[i]] = i;
+		}
+	});
+
+	header.inverse = 1;
+	relabelWrite(folder / __RELABELINV, header, inv.data());
+}
+
+sp<RelabelTable> relabelLoad(fs::path const & path)
+{
+	auto file = fileMap(path);
+
+	RelabelHeader header = {0, 0, 0, 0, 0, 0};
+	memcpy(&header, file->addr, std::min(file->byte, sizeof(header)));
+
+	// an older table has no counts; the grid width is then chosen from the input, as without one
+	auto headerByte = sizeof(header);
+	if (header.magic == __RELABEL1_MAGIC) {
+		headerByte	  = offsetof(RelabelHeader, active);
+		header.magic  = __RELABEL_MAGIC;
+		header.active = header.vertices;
+		header.edges  = 0;
+	}
+
+	if (header.magic != __RELABEL_MAGIC ||
+		file->byte != headerByte + header.vertices * sizeof(uint64_t)) {
+		fprintf(stderr, "not a relabel table: %s\n", path.c_str());
+		exit(EXIT_FAILURE);
+	}
+
+	// looked up in input order, not front to back
+	if (file->mapped) {
+		madvise((void *)file->addr, file->byte, MADV_RANDOM);
+	}
+
+	auto out		 = makeSp<RelabelTable>();
+	out->file		 = file;
+	out->relabelType = header.relabelType;
+	out->map		 = (uint64_t const *)&file->addr[headerByte];
+	out->size		 = header.vertices;
+	out->active		 = header.active;
+	out->edges		 = header.edges;
+
+	return out;
+}
+
+void relabelLink(fs::path const & fwdPath, fs::path const & folder)
+{
+	auto invPath = fwdPath.parent_path() / __RELABELINV;
+
+	for (auto & from : {fwdPath, invPath}) {
+		auto to = folder / from.filename();
+		if (!fs::exists(from) || fs::exists(to)) {
+			continue;
+		}
+
+		// tables are never rewritten in place, so a hard link is as good as a copy
+		std::error_code ec;
+		fs::create_hard_link(from, to, ec);
+		if (ec) {
+			fs::copy_file(from, to);
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef FCA16155_4E8D_4E56_AFE7_447816095B4D
+#define FCA16155_4E8D_4E56_AFE7_447816095B4D
+
+#include "type.h"
+#include "util.h"
+
+#include <vector>
+
+#define __RELABELFWD "relabel.fwd" // old -> new vertex IDs, written by Stage0 next to the output
+#define __RELABELINV "relabel.inv" // new -> old
+
+// relabel file: a RelabelHeader followed by one uint64_t per vertex, so entry i of a mapped
+// table sits at sizeof(RelabelHeader) + 8 * i; the tables of older converters ("Relabel1") end
+// their header before active
+struct RelabelHeader {
+	uint64_t magic, relabelType, vertices, inverse;
+	uint64_t active; // vertices with at least one edge; they take the new IDs [0, active)
+	uint64_t edges;	 // input edges without self loops, duplicates included
+};
+
+// a relabel file mapped into memory
+struct RelabelTable {
+	sp<FileView>	 file;
+	uint64_t		 relabelType;
+	uint64_t const * map;
+	size_t			 size;
+	uint64_t		 active;
+	uint64_t		 edges;
+
+	uint64_t at(uint64_t const v) const
+	{
+		if (v >= this->size) {
+			fprintf(stderr, "vertex %ld is out of the relabel table (%ld)\n", v, this->size);
+			exit(EXIT_FAILURE);
+		}
+		return this->map[v];
+	}
+};
+
+sp<RelabelTable> relabelLoad(fs::path const & path);
+void			 relabelLink(fs::path const & fwdPath, fs::path const & folder);
+
+void relabelSave(fs::path const & folder, std::vector<uint64_t> const & fwd, RelabelHeader header);
+
+#endif /* FCA16155_4E8D_4E56_AFE7_447816095B4D */
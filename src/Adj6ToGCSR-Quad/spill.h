@@ -0,0 +1,157 @@
+#ifndef B92F5EFC_FD9C_4529_8F4C_E5298E1FE0F5
+#define B92F5EFC_FD9C_4529_8F4C_E5298E1FE0F5
+
+#include "type.h"
+#include "util.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tbb/concurrent_unordered_map.h>
+#include <thread>
+#include <vector>
+
+#define __SPILLBUDGET  (1L << 33) // 8GB of staged edges, shared by every shuffler
+#define __SPILLCHUNK   (1L << 23) // 8MB, one append
+#define __SPILLWRITERS 4
+#define __SPILLFDS	   256 // open descriptors kept by each writer
+#define __SPILLRUN	   ".run" // run lengths (uint64_t edges) of a spilled grid, next to its file
+
+// Stage1 spill buffers, shared by all shufflers.
+// Edges are staged per grid in fixed-size chunks carved out of one arena, so memory stays within
+// the budget whatever the thread and grid counts are. Full chunks go to the writer that owns the
+// grid's file; it keeps the descriptor open, sorts and dedups the chunk and appends it as one run.
+// The run lengths go to the __SPILLRUN sidecar so Stage2 can merge instead of re-sorting.
+class Spiller
+{
+private:
+	struct Partition {
+		std::mutex lock;
+
+		E32	   grid;
+		E32 *  chunk;
+		size_t count;
+	};
+
+	struct SpillJob {
+		E32	   grid;
+		E32 *  chunk;
+		size_t count;
+	};
+
+	fs::path	folder;
+	std::string ext;
+	size_t		chunkEdges;
+
+	std::unique_ptr<E32[]> arena;
+	sp<bchan<E32 *>>	   freeChunks;
+
+	tbb::concurrent_unordered_map<uint64_t, sp<Partition>> partitions;
+
+	std::vector<sp<bchan<SpillJob>>> jobs;
+	std::vector<std::thread>		 writers;
+
+	Partition & partition(E32 const & grid);
+	E32 *		acquire(Partition const & self);
+	bool		evict(Partition const & self);
+	void		submit(Partition & part);
+	void		writer(size_t const id);
+
+public:
+	void init(fs::path const &	  folder,
+			  std::string const & ext,
+			  size_t const		  budgetByte,
+			  size_t const		  chunkByte,
+			  size_t const		  writerCount);
+	~Spiller() noexcept;
+
+	// thread-safe; appends count edges to the grid's file, eventually
+	void push(E32 const & grid, E32 const * edges, size_t const count);
+
+	// writes out every partially filled chunk and waits for the writers
+	void close();
+};
+
+// the part of budgetByte the spill arenas may take, a quarter of the machine at most; spillers
+// sharing a budget split this, not budgetByte
+size_t spillBudget(size_t const budgetByte);
+
+#define __MERGEWIN 4096 // edges decoded ahead per run
+
+// calls func(E32 const &) for every distinct edge of the sorted runs in el32, in order
+template <typename Func>
+void forEachMergedEdge(FileView const & el32, std::vector<uint64_t> const & runs, Func func)
+{
+	struct Cursor {
+		E32 const *			 pos; // decoded edges not merged yet
+		E32 const *			 end;
+		uint8_t const *		 src; // next edge still encoded in el32
+		size_t				 left;
+		sp<std::vector<E32>> win;
+
+		bool refill()
+		{
+#ifdef __PACK24
+			auto n = std::min(this->left, size_t(__MERGEWIN));
+			unpack24_bulk(this->src, this->win->data(), n);
+			this->pos = this->win->data();
+			this->end = this->pos + n;
+#else
+			auto n	  = this->left;
+			this->pos = (E32 const *)this->src;
+			this->end = this->pos + n;
+#endif
+			this->src += n * __EDGEBYTE;
+			this->left -= n;
+			return n > 0;
+		}
+	};
+
+	// min-heap on the head edge of each run
+	auto later = [](Cursor const & l, Cursor const & r) { return *r.pos < *l.pos; };
+
+	std::vector<Cursor> heap;
+	size_t				pos = 0;
+	for (auto run : runs) {
+		Cursor c;
+		c.src  = &el32.addr[pos * __EDGEBYTE];
+		c.left = run;
+#ifdef __PACK24
+		c.win = makeSp<std::vector<E32>>(std::min(run, uint64_t(__MERGEWIN)));
+#endif
+		if (c.refill()) {
+			heap.push_back(c);
+		}
+		pos += run;
+	}
+	std::make_heap(heap.begin(), heap.end(), later);
+
+	bool first = true;
+	E32	 last;
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), later);
+		auto & c = heap.back();
+
+		// drain the run while it stays at or below every other head
+		do {
+			if (first || *c.pos != last) {
+				func(*c.pos);
+				last  = *c.pos;
+				first = false;
+			}
+			c.pos++;
+			if (c.pos == c.end && !c.refill()) {
+				break;
+			}
+		} while (heap.size() == 1 || !(*heap.front().pos < *c.pos));
+
+		if (c.pos == c.end) {
+			heap.pop_back();
+		} else {
+			std::push_heap(heap.begin(), heap.end(), later);
+		}
+	}
+}
+
+#endif /* B92F5EFC_FD9C_4529_8F4C_E5298E1FE0F5 */
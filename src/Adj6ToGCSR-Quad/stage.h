@@ -1,23 +1,32 @@
 #ifndef E50D46DC_7197_4A21_9962_83851F3004D8
 #define E50D46DC_7197_4A21_9962_83851F3004D8
 
+#include "manifest.h"
+#include "relabel.h"
 #include "type.h"
+#include "util.h"
 
 #include <stdint.h>
-sp<std::vector<uint64_t>> stage0(fs::path const & inFolder,
-								 fs::path const & outFolder,
-								 uint64_t const	  maxVID,
-								 uint64_t const	  relabelType);
+sp<RelabelTable> stage0(fs::path const & inFolder,
+						fs::path const & outFolder,
+						uint64_t const	 maxVID,
+						uint64_t const	 relabelType);
 
-void stage1(fs::path const &		  inFolder,
-			fs::path const &		  outFolder,
-			uint32_t const			  gridWidth,
-			bool const				  lowerTriangular,
-			bool const				  relabel,
-			sp<std::vector<uint64_t>> relabelTable);
+void stage1(fs::path const & inFolder,
+			fs::path const & outFolder,
+			uint32_t const	 gridWidth,
+			bool const		 lowerTriangular,
+			bool const		 relabel,
+			sp<RelabelTable> relabelTable,
+			bool const		 symmetric,
+			fs::path const & transposeFolder);
 
-void stage2(fs::path const & outFolder);
-void stage3(fs::path const & outFolder, uint32_t const gridWidth, size_t const limitByte);
-void stage4(fs::path const & outFolder);
+void stage2(fs::path const & outFolder, Manifest & manifest);
+void stage3(fs::path const & outFolder,
+			uint32_t const	 gridWidth,
+			size_t const	 limitByte,
+			bool const		 balanced,
+			Manifest &		 manifest);
+void stage4(fs::path const & outFolder, bool const compress, Manifest & manifest);
 
 #endif /* E50D46DC_7197_4A21_9962_83851F3004D8 */
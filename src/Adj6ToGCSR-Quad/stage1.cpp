@@ -1,3 +1,6 @@
+#include "input.h"
+#include "relabel.h"
+#include "spill.h"
 #include "type.h"
 #include "util.h"
 
@@ -14,39 +17,42 @@ static auto make_unordered_map(
 	return std::unordered_map<Key, Val, Hash, Equal>(bucket_count, hash, equal);
 }
 
-static auto mapper(sp<std::vector<uint8_t>> adj6,
-				   sp<bchan<RowPos>>		in,
-				   uint32_t const			gridWidth,
-				   bool const				lowerTriangular)
+static auto mapper(sp<FileView>		   input,
+				   sp<bchan<RowBlock>> in,
+				   uint32_t const	   gridWidth,
+				   bool const		   lowerTriangular)
 {
 	auto out = makeSp<bchan<sp<std::vector<GE32>>>>(16);
 	std::thread([=] {
-		for (auto dat : *in) {
-			auto el		  = makeSp<std::vector<GE32>>(dat.cnt);
-			auto selfloop = uint64_t(0);
-
-			for (uint64_t i = 0; i < dat.cnt; i++) {
-				auto src = dat.src;
-				auto dst = be6_le8(&(adj6->at(dat.dstStart + i * 6)));
-
-				if (lowerTriangular && src < dst) {
-					std::swap(src, dst);
-				} else if (src == dst) {
-					selfloop++;
-					continue;
+		InputBuffer buf;
+		for (auto blk : *in) {
+			// a block of n bytes holds at most n/6 Adj6 edges, and text is rarely denser
+			auto el = makeSp<std::vector<GE32>>();
+			el->reserve((blk.end - blk.begin) / 6);
+
+			auto row = [&](uint64_t const s, uint64_t const * d, size_t const cnt) {
+				for (size_t i = 0; i < cnt; i++) {
+					auto src = s;
+					auto dst = d[i];
+
+					if (lowerTriangular && src < dst) {
+						std::swap(src, dst);
+					} else if (src == dst) {
+						continue;
+					}
+
+					GE32 ge32;
+
+					ge32[0][0] = (uint32_t)(src / gridWidth);
+					ge32[0][1] = (uint32_t)(dst / gridWidth);
+					ge32[1][0] = (uint32_t)(src % gridWidth);
+					ge32[1][1] = (uint32_t)(dst % gridWidth);
+
+					el->push_back(ge32);
 				}
+			};
+			forEachInputRow(*input, blk, buf, row);
 
-				GE32 ge32;
-
-				ge32[0][0] = (uint32_t)(src / gridWidth);
-				ge32[0][1] = (uint32_t)(dst / gridWidth);
-				ge32[1][0] = (uint32_t)(src % gridWidth);
-				ge32[1][1] = (uint32_t)(dst % gridWidth);
-
-				el->at(i - selfloop) = ge32;
-			}
-
-			el->resize(el->size() - selfloop);
 			out->push(el);
 		}
 		out->close();
@@ -54,40 +60,43 @@ static auto mapper(sp<std::vector<uint8_t>> adj6,
 	return out;
 }
 
-static auto mapper_relabel(sp<std::vector<uint8_t>>	 adj6,
-						   sp<std::vector<uint64_t>> relabelTable,
-						   sp<bchan<RowPos>>		 in,
-						   uint32_t const			 gridWidth,
-						   bool const				 lowerTriangular)
+static auto mapper_relabel(sp<FileView>		   input,
+						   sp<RelabelTable>	   relabelTable,
+						   sp<bchan<RowBlock>> in,
+						   uint32_t const	   gridWidth,
+						   bool const		   lowerTriangular)
 {
 	auto out = makeSp<bchan<sp<std::vector<GE32>>>>(16);
 	std::thread([=] {
-		for (auto dat : *in) {
-			auto el		  = makeSp<std::vector<GE32>>(dat.cnt);
-			auto selfloop = uint64_t(0);
-
-			for (uint64_t i = 0; i < dat.cnt; i++) {
-				auto src = relabelTable->at(dat.src);
-				auto dst = relabelTable->at(be6_le8(&(adj6->at(dat.dstStart + i * 6))));
-
-				if (lowerTriangular && src < dst) {
-					std::swap(src, dst);
-				} else if (src == dst) {
-					selfloop++;
-					continue;
+		InputBuffer buf;
+		for (auto blk : *in) {
+			// a block of n bytes holds at most n/6 Adj6 edges, and text is rarely denser
+			auto el = makeSp<std::vector<GE32>>();
+			el->reserve((blk.end - blk.begin) / 6);
+
+			auto row = [&](uint64_t const s, uint64_t const * d, size_t const cnt) {
+				for (size_t i = 0; i < cnt; i++) {
+					auto src = relabelTable->at(s);
+					auto dst = relabelTable->at(d[i]);
+
+					if (lowerTriangular && src < dst) {
+						std::swap(src, dst);
+					} else if (src == dst) {
+						continue;
+					}
+
+					GE32 ge32;
+
+					ge32[0][0] = (uint32_t)(src / gridWidth);
+					ge32[0][1] = (uint32_t)(dst / gridWidth);
+					ge32[1][0] = (uint32_t)(src % gridWidth);
+					ge32[1][1] = (uint32_t)(dst % gridWidth);
+
+					el->push_back(ge32);
 				}
+			};
+			forEachInputRow(*input, blk, buf, row);
 
-				GE32 ge32;
-
-				ge32[0][0] = (uint32_t)(src / gridWidth);
-				ge32[0][1] = (uint32_t)(dst / gridWidth);
-				ge32[1][0] = (uint32_t)(src % gridWidth);
-				ge32[1][1] = (uint32_t)(dst % gridWidth);
-
-				el->at(i - selfloop) = ge32;
-			}
-
-			el->resize(el->size() - selfloop);
 			out->push(el);
 		}
 		out->close();
@@ -95,68 +104,99 @@ static auto mapper_relabel(sp<std::vector<uint8_t>>	 adj6,
 	return out;
 }
 
-static void
-shuffler(sp<bchan<sp<std::vector<GE32>>>> in, fs::path const & folder, std::string const & ext)
+// Routes the edges to their grids; with transposed, each edge also goes to the <col>-<row> grid
+// there with its local IDs swapped, and symmetric puts that mirror into the same grids instead.
+static void shuffler(sp<bchan<sp<std::vector<GE32>>>> in,
+					 Spiller &						  spiller,
+					 Spiller *						  transposed,
+					 bool const						  symmetric)
 {
-
-	auto map = make_unordered_map<E32, sp<std::vector<E32>>>(
-		128,
-		[](E32 const & k) {
-			auto a = std::hash<uint64_t>{}(uint64_t(k[0]) << (8 * sizeof(k[0])));
-			auto b = std::hash<uint64_t>{}(k[1]);
-			return a ^ b;
-		},
-		[](E32 const & kl, E32 const & kr) { return (kl[0] == kr[0] && kl[1] == kr[1]); });
+	auto makeMap = [] {
+		return make_unordered_map<E32, std::vector<E32>>(
+			128,
+			[](E32 const & k) {
+				auto a = std::hash<uint64_t>{}(uint64_t(k[0]) << (8 * sizeof(k[0])));
+				auto b = std::hash<uint64_t>{}(k[1]);
+				return a ^ b;
+			},
+			[](E32 const & kl, E32 const & kr) { return (kl[0] == kr[0] && kl[1] == kr[1]); });
+	};
+	auto map  = makeMap();
+	auto tmap = makeMap();
+
+	// a symmetric mirror goes into the grids of the edge itself
+	auto & mirror = (symmetric) ? map : tmap;
 
 	for (auto dat : *in) {
-		for (auto ge : *dat) {
-			if (map.find(ge[0]) == map.end()) {
-				map[ge[0]] = makeSp<std::vector<E32>>();
-			}
-			map[ge[0]]->push_back(ge[1]);
-
-			// flush
-			if (map[ge[0]]->size() > (1 << 20)) {
-				auto targetFile = folder / fs::path(fileNameEncode(ge[0], ext));
-				fileSaveAppend(targetFile, map[ge[0]]->data(), map[ge[0]]->size() * sizeof(ge[0]));
-				map[ge[0]]->resize(0);
+		// group the block by grid so each grid takes the spill lock once per block
+		for (auto & ge : *dat) {
+			map[ge[0]].push_back(ge[1]);
+			if (symmetric || transposed != nullptr) {
+				mirror[E32{ge[0][1], ge[0][0]}].push_back(E32{ge[1][1], ge[1][0]});
 			}
 		}
-	}
 
-	// flush
-	for (auto & kv : map) {
-		if (kv.second->size() > 0) {
-			auto targetFile = folder / fs::path(fileNameEncode(kv.first, ext));
-			fileSaveAppend(targetFile, kv.second->data(), kv.second->size() * sizeof(kv.first));
+		for (auto & kv : map) {
+			spiller.push(kv.first, kv.second.data(), kv.second.size());
+		}
+		for (auto & kv : tmap) {
+			transposed->push(kv.first, kv.second.data(), kv.second.size());
 		}
+
+		map.clear();
+		tmap.clear();
 	}
 }
 
-void stage1(fs::path const &		  inFolder,
-			fs::path const &		  outFolder,
-			uint32_t const			  gridWidth,
-			bool const				  lowerTriangular,
-			bool const				  relabel,
-			sp<std::vector<uint64_t>> relabelTable)
+void stage1(fs::path const & inFolder,
+			fs::path const & outFolder,
+			uint32_t const	 gridWidth,
+			bool const		 lowerTriangular,
+			bool const		 relabel,
+			sp<RelabelTable> relabelTable,
+			bool const		 symmetric,
+			fs::path const & transposeFolder)
 {
+	// the spillers append to the grid files; clear what an interrupted run left of them, in the
+	// transposed dataset below the output too
+	for (auto ext : {".el32", __SPILLRUN}) {
+		auto leftovers = fileList(outFolder, ext);
+		for (auto & f : *leftovers) {
+			fs::remove(f);
+		}
+	}
+
+	auto fListChan = fileMapList(fileList(inFolder, ""));
 
-	auto fListChan = fileList(inFolder, "");
+	// the transposed grids take half of the staging memory, after it is fit to the machine
+	auto const budget = spillBudget(__SPILLBUDGET) / ((transposeFolder.empty()) ? 1 : 2);
+
+	Spiller spiller, transposed;
+	spiller.init(outFolder, ".el32", budget, __SPILLCHUNK, __SPILLWRITERS);
+	if (!transposeFolder.empty()) {
+		transposed.init(transposeFolder, ".el32", budget, __SPILLCHUNK, __SPILLWRITERS);
+	}
 
 	parallelDo(8, [&](size_t const i) {
-		for (auto & fPath : *fListChan) {
-			stopwatch("Stage1, " + std::string(fPath), [&] {
-				auto adj6		= fileLoad<uint8_t>(fPath);
-				auto rowPosChan = splitAdj6(adj6);
+		for (auto & input : *fListChan) {
+			stopwatch("Stage1, " + std::string(input->path), [&] {
+				auto rowChan = splitInput(input, outFolder);
 
 				parallelDo(64, [&](size_t const i) {
 					auto mapped =
 						(relabel) ? mapper_relabel(
-										adj6, relabelTable, rowPosChan, gridWidth, lowerTriangular)
-								  : mapper(adj6, rowPosChan, gridWidth, lowerTriangular);
-					shuffler(mapped, outFolder, ".el32");
+										input, relabelTable, rowChan, gridWidth, lowerTriangular)
+								  : mapper(input, rowChan, gridWidth, lowerTriangular);
+					shuffler(mapped,
+							 spiller,
+							 (transposeFolder.empty()) ? nullptr : &transposed,
+							 symmetric);
 				});
 			});
 		}
 	});
+	spiller.close();
+	if (!transposeFolder.empty()) {
+		transposed.close();
+	}
 }
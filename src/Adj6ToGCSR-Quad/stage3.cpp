@@ -2,261 +2,223 @@
 #include "type.h"
 #include "util.h"
 
-#include <atomic>
-#include <chrono>
-#include <fstream>
-#include <iostream>
-#include <regex>
-#include <tbb/blocked_range.h>
+#include <algorithm>
+#include <array>
+#include <memory>
 #include <tbb/parallel_for.h>
-#include <tbb/parallel_reduce.h>
-#include <tbb/parallel_scan.h>
-#include <tbb/parallel_sort.h>
 #include <thread>
+#include <vector>
 
-struct ShardIndex {
-	std::array<V32, 2> grid, shard;
-	uint32_t		   depth;
-	std::string		   string() const;
-	bool			   parse(std::string const & in);
+#define __QUADGRAIN (1L << 16) // edges per partition block, at least
+
+// Cuts of one split: rows below row go up, columns below col[0] (upper half) or col[1] (lower half)
+// go left. A cut at the end of its range leaves that side empty.
+struct QuadCut {
+	V32				   row;
+	std::array<V32, 2> col;
+
+	// quadrant 0..3, row-major
+	size_t of(E32 const & e) const
+	{
+		auto lower = size_t(e[0] >= this->row);
+		return (lower << 1) | size_t(e[1] >= this->col[lower]);
+	}
 };
 
-std::string ShardIndex::string() const
+// Edge-balanced cut of [begin, end): of count keys, below are less than the median key and upto
+// are at most the median. Cuts at the median or right after it, whichever is closer to half.
+static V32 balancedCut(V32 const	begin,
+					   V32 const	end,
+					   V32 const	median,
+					   size_t const below,
+					   size_t const upto,
+					   size_t const count)
 {
-	if (this->depth > 0) {
-		return std::to_string(this->grid[0]) + "-" + std::to_string(this->grid[1]) + "," +
-			   std::to_string(this->depth) + "," + std::to_string(this->shard[0]) + "-" +
-			   std::to_string(this->shard[1]);
-	} else {
-		return std::to_string(this->grid[0]) + "-" + std::to_string(this->grid[1]);
+	if (end - begin <= 1) {
+		return end;
 	}
+	auto cut = (2 * upto - count < count - 2 * below) ? median + 1 : median;
+	return std::min(std::max(cut, begin + 1), end - 1);
 }
 
-bool ShardIndex::parse(std::string const & in)
+// data is sorted by edgeKey, so the rows come directly; each half's columns need a selection
+static QuadCut balancedCuts(E32 const * data, size_t const count, ShardIndex const & sidx)
 {
-	*this = {
-		0,
-	};
-
-	std::regex	regex("^(\\d*)-(\\d*)(?:,(\\d*),(\\d*)-(\\d*))?$");
-	std::smatch m;
-
-	if (std::regex_match(in, m, regex)) {
-		if (m[1].length() > 0) {
-			this->grid[0] = strtol(std::string(m[1]).c_str(), nullptr, 10);
-		}
-
-		if (m[2].length() > 0) {
-			this->grid[1] = strtol(std::string(m[2]).c_str(), nullptr, 10);
-		}
-
-		if (m[3].length() > 0) {
-			this->depth = strtol(std::string(m[3]).c_str(), nullptr, 10);
-		} else {
-			return true;
+	QuadCut cut;
+
+	auto & rows	  = sidx.range[0];
+	auto   median = data[count / 2][0];
+	auto   below  = std::lower_bound(data, data + count, E32{median, 0}) - data;
+	auto   upto	  = std::upper_bound(data, data + count, E32{median, UINT32_MAX}) - data;
+	cut.row		  = balancedCut(rows[0], rows[1], median, below, upto, count);
+
+	size_t cutPos  = std::lower_bound(data, data + count, E32{cut.row, 0}) - data;
+	size_t half[3] = {0, cutPos, count};
+	tbb::parallel_for(size_t(0), size_t(2), [&](size_t const h) {
+		auto & cols = sidx.range[1];
+		auto   n	= half[h + 1] - half[h];
+		if (n == 0) {
+			cut.col[h] = cols[1];
+			return;
 		}
 
-		if (m[4].length() > 0) {
-			this->shard[0] = strtol(std::string(m[4]).c_str(), nullptr, 10);
-		} else {
+		std::vector<V32> col(n);
+		for (size_t i = 0; i < n; i++) {
+			col[i] = data[half[h] + i][1];
 		}
+		std::nth_element(col.begin(), col.begin() + n / 2, col.end());
 
-		if (m[5].length() > 0) {
-			this->shard[1] = strtol(std::string(m[5]).c_str(), nullptr, 10);
-		} else {
+		auto   median = col[n / 2];
+		size_t below = 0, upto = 0;
+		for (auto c : col) {
+			below += (c < median);
+			upto += (c <= median);
 		}
+		cut.col[h] = balancedCut(cols[0], cols[1], median, below, upto, n);
+	});
 
-		return true;
-	} else {
-		return false;
-	}
+	return cut;
 }
 
-static auto quad(sp<std::vector<E32>> in, uint32_t const gridWidth, size_t const currentDepth)
+// geometric midpoint of the cell, the same for both halves
+static QuadCut midpointCuts(ShardIndex const & sidx)
 {
-	// init
-	// auto out = makeSp<std::vector<std::vector<E32>>>(in->size());
-
-	auto out = makeSp<std::array<std::array<std::vector<E32>, 2>, 2>>();
-
-	// sort only src of edge
-	tbb::parallel_sort(
-		in->begin(), in->end(), [&](E32 const & l, E32 const & r) { return (l[0] < r[0]); });
-
-	auto currWidth = (gridWidth >> currentDepth);
-	auto nextWidth = (gridWidth >> (currentDepth + 1));
-
-	// printf("%d, %d\n", currWidth, nextWidth);
-
-	size_t rowCut = in->size();
-
-	// printf("QUAD A\n");
-	tbb::parallel_for(
-		tbb::blocked_range<size_t>(0, in->size() - 1),
-		[&](tbb::blocked_range<size_t> const & r) {
-			for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-				for (size_t offset = 0; offset < r.grainsize(); offset++) {
-					auto curr = grain + offset;
-					auto next = curr + 1;
-
-					if ((in->at(curr)[0] / nextWidth) != (in->at(next)[0] / nextWidth)) {
-						rowCut = next;
-						// printf("%d / %d != %d / %d, rowCut: %d\n", in->at(curr)[0], nextWidth,
-						// in->at(next)[0], nextWidth, rowCut);
-						tbb::task::self().cancel_group_execution();
-						return;
-					}
-
-					if (tbb::task::self().is_cancelled()) {
-						return;
-					}
-				}
-			}
-		},
-		tbb::auto_partitioner());
+	QuadCut cut;
+	cut.row	   = sidx.range[0][0] + (sidx.range[0][1] - sidx.range[0][0]) / 2;
+	cut.col[0] = sidx.range[1][0] + (sidx.range[1][1] - sidx.range[1][0]) / 2;
+	cut.col[1] = cut.col[0];
+	return cut;
+}
 
-	// printf("rowCut = %d\n", rowCut);
-	size_t colCut[2] = {rowCut, in->size()};
-	// printf("QUAD B\n");
+// Stable partition of in[0, count) into out by quadrant; sorted input gives sorted quadrants.
+// Returns the quadrant bounds in out.
+static std::array<size_t, 5>
+quadPartition(E32 const * in, size_t const count, E32 * out, QuadCut const & cut)
+{
+	using Hist = std::array<size_t, 4>;
 
-	parallelDo(2, [&](size_t const idx) {
-		// sort only dst of edge
+	size_t const threads  = std::max(1U, std::thread::hardware_concurrency());
+	size_t const blocks	  = std::max(size_t(1), std::min(threads, count / __QUADGRAIN));
+	auto		 blockPos = [&](size_t const b) { return count * b / blocks; };
 
-		auto range = tbb::blocked_range<size_t>(0, 1);
-		switch (idx) {
-		case 0:
-			range = tbb::blocked_range<size_t>(0, rowCut - 1);
-			tbb::parallel_sort(in->begin(),
-							   in->begin() + rowCut,
-							   [&](E32 const & l, E32 const & r) { return (l[1] < r[1]); });
-			break;
-		case 1:
-			range = tbb::blocked_range<size_t>(rowCut, in->size() - 1);
-			tbb::parallel_sort(in->begin() + rowCut, in->end(), [&](E32 const & l, E32 const & r) {
-				return (l[1] < r[1]);
-			});
-			break;
+	std::vector<Hist> hist(blocks);
+	tbb::parallel_for(size_t(0), blocks, [&](size_t const b) {
+		hist[b].fill(0);
+		for (size_t i = blockPos(b); i < blockPos(b + 1); i++) {
+			hist[b][cut.of(in[i])]++;
 		}
-
-		tbb::parallel_for(
-			range,
-			[&](tbb::blocked_range<size_t> const & r) {
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto curr = grain + offset;
-						auto next = curr + 1;
-
-						if (((*in)[curr][1] / nextWidth) != ((*in)[next][1] / nextWidth)) {
-							colCut[idx] = next;
-							tbb::task::self().cancel_group_execution();
-							return;
-						}
-
-						if (tbb::task::self().is_cancelled()) {
-							return;
-						}
-					}
-				}
-			},
-			tbb::auto_partitioner());
 	});
-	// printf("QUAD C\n");
-	// printf("CUT: %ld, %ld, %ld, %ld, %ld\n", 0UL, colCut[0], rowCut, colCut[1], in->size());
 
-	// sort
-	parallelDo(4, [&](size_t const i) {
-		switch (i) {
-		case 0:
-			(*out)[0][0].resize(colCut[0]);
-			memcpy((*out)[0][0].data(), &((*in)[0]), (*out)[0][0].size() * sizeof(E32));
-			break;
-		case 1:
-			(*out)[0][1].resize(rowCut - colCut[0]);
-			memcpy((*out)[0][1].data(), &((*in)[colCut[0]]), (*out)[0][1].size() * sizeof(E32));
-			break;
-		case 2:
-			(*out)[1][0].resize(colCut[1] - rowCut);
-			memcpy((*out)[1][0].data(), &((*in)[rowCut]), (*out)[1][0].size() * sizeof(E32));
-			break;
-		case 3:
-			(*out)[1][1].resize(in->size() - colCut[1]);
-			memcpy((*out)[1][1].data(), &((*in)[colCut[1]]), (*out)[1][1].size() * sizeof(E32));
-			break;
+	// quadrant-major, block-minor exclusive sum keeps the partition stable
+	std::array<size_t, 5> bound;
+	size_t				  sum = 0;
+	for (size_t q = 0; q < 4; q++) {
+		bound[q] = sum;
+		for (size_t b = 0; b < blocks; b++) {
+			auto c	   = hist[b][q];
+			hist[b][q] = sum;
+			sum += c;
 		}
-		tbb::parallel_sort((*out)[i / 2][i % 2].begin(),
-						   (*out)[i / 2][i % 2].end(),
-						   [&](E32 const & l, E32 const & r) {
-							   return (l[0] < r[0]) || ((l[0] == r[0]) && (l[1] < r[1]));
-						   });
-	});
+	}
+	bound[4] = sum;
 
-	// printf("size\n" "%ld, %ld\n" "%ld, %ld\n", out->at(0).at(0).size(), out->at(0).at(1).size(),
-	// out->at(1).at(0).size(), out->at(1).at(1).size());
+	tbb::parallel_for(size_t(0), blocks, [&](size_t const b) {
+		auto & pos = hist[b];
+		for (size_t i = blockPos(b); i < blockPos(b + 1); i++) {
+			out[pos[cut.of(in[i])]++] = in[i];
+		}
+	});
 
-	return out;
+	return bound;
 }
 
-void stage3(fs::path const & outFolder, uint32_t const gridWidth, size_t const limitByte)
+// Splits data[0, count) of one shard until every part holds at most limitEdges edges or the cell
+// is a single vertex, and writes only the leaves. scratch is as long as data; the two swap roles
+// at every level, so a grid is split with no memory beyond twice its size.
+static void quadSplit(E32 *				 data,
+					  E32 *				 scratch,
+					  size_t const		 count,
+					  ShardIndex const & sidx,
+					  size_t const		 limitEdges,
+					  bool const		 balanced,
+					  fs::path const &	 folder)
 {
-	bool exist = true;
-	while (exist) {
-		// consider that exists
-		exist = false;
-
-		auto jobs = [&] {
-			auto out = makeSp<bchan<fs::path>>(128);
-			std::thread([=, &exist] {
-				auto fListChan = fileListOver(outFolder, ".el32", limitByte * 2);
-				for (auto & f : *fListChan) {
-					out->push(f);
-					exist = true;
-				}
-				out->close();
-			}).detach();
-			return out;
-		}();
-
-		parallelDo(4, [&](size_t const i) {
-			for (auto & fPath : *jobs) {
-				stopwatch("Stage3, " + std::string(fPath), [&] {
-					if (fs::file_size(fPath) == 0) {
-						return;
-					}
-					// regex parse required
-					auto	   rawData = fileLoad<E32>(fPath);
-					ShardIndex sidx;
-					sidx.parse(fPath.stem());
-					// printf("sidx: (%d,%d),%d,(%d,%d)\n", sidx.grid[0], sidx.grid[1], sidx.depth,
-					// sidx.shard[0], sidx.shard[1]);
+	if (count == 0) {
+		return;
+	}
 
-					auto quaded = quad(rawData, gridWidth, sidx.depth);
+	auto & range = sidx.range;
+	if (count <= limitEdges || (range[0][1] - range[0][0] <= 1 && range[1][1] - range[1][0] <= 1)) {
+		auto target = folder / fs::path(sidx.string() + ".el32");
+		edgeSave(target, data, count);
+		fileSync(target);
+		return;
+	}
 
-					// printf("QUAD D\n");
-					std::array<std::array<ShardIndex, 2>, 2> sidxNew;
-					parallelDo(4, [&](size_t const idx) {
-						auto r = idx / 2, c = idx % 2;
-						sidxNew[r][c].grid	   = sidx.grid;
-						sidxNew[r][c].depth	   = sidx.depth + 1;
-						sidxNew[r][c].shard[0] = sidx.shard[0] * 2 + r;
-						sidxNew[r][c].shard[1] = sidx.shard[1] * 2 + c;
-					});
-					// printf("QUAD E\n");
+	auto cut   = balanced ? balancedCuts(data, count, sidx) : midpointCuts(sidx);
+	auto bound = quadPartition(data, count, scratch, cut);
+
+	// sibling subtrees are independent
+	tbb::parallel_for(size_t(0), size_t(4), [&](size_t const q) {
+		auto r = q / 2, c = q % 2;
+
+		ShardIndex child;
+		child.grid	   = sidx.grid;
+		child.depth	   = sidx.depth + 1;
+		child.shard[0] = sidx.shard[0] * 2 + r;
+		child.shard[1] = sidx.shard[1] * 2 + c;
+		child.ranged   = balanced;
+		child.range[0] = (r == 0) ? std::array<V32, 2>{range[0][0], cut.row}
+								  : std::array<V32, 2>{cut.row, range[0][1]};
+		child.range[1] = (c == 0) ? std::array<V32, 2>{range[1][0], cut.col[r]}
+								  : std::array<V32, 2>{cut.col[r], range[1][1]};
+
+		quadSplit(&scratch[bound[q]],
+				  &data[bound[q]],
+				  bound[q + 1] - bound[q],
+				  child,
+				  limitEdges,
+				  balanced,
+				  folder);
+	});
+}
 
-					parallelDo(4, [&](size_t const idx) {
-						auto r = idx / 2, c = idx % 2;
-						auto target =
-							fPath.parent_path() / fs::path(sidxNew[r][c].string() + ".el32");
-						if ((*quaded)[r][c].size() > 0) {
-							fileSave(target,
-									 (*quaded)[r][c].data(),
-									 (*quaded)[r][c].size() * sizeof(E32));
-						}
-					});
-					// printf("QUAD F\n");
+void stage3(fs::path const & outFolder,
+			uint32_t const	 gridWidth,
+			size_t const	 limitByte,
+			bool const		 balanced,
+			Manifest &		 manifest)
+{
+	// limitByte * 2 of E32 edges, in intermediate bytes
+	auto limitEdges = limitByte * 2 / sizeof(E32);
+	auto jobs		= fileListOver(outFolder, ".el32", limitEdges * __EDGEBYTE);
 
-					fs::remove(fPath);
-				});
-			}
-		});
-	}
-}
\ No newline at end of file
+	// every oversized grid is loaded once and split down to its leaves in memory
+	parallelDo(4, [&](size_t const i) {
+		for (auto & fPath : *jobs) {
+			stopwatch("Stage3, " + std::string(fPath), [&] {
+				ShardIndex sidx;
+				sidx.parse(fPath.stem());
+				sidx.range[0] = {0, gridWidth};
+				sidx.range[1] = {0, gridWidth};
+
+				// leaves keep the same names when a grid is split again after a crash
+				auto stem = fPath.stem().string();
+				if (!manifest.done("Stage3", stem)) {
+					auto rawData = edgeLoad(fPath);
+
+					std::unique_ptr<E32[]> scratch(new E32[rawData->size()]);
+					quadSplit(rawData->data(),
+							  scratch.get(),
+							  rawData->size(),
+							  sidx,
+							  limitEdges,
+							  balanced,
+							  fPath.parent_path());
+					manifest.finish("Stage3", stem);
+				}
+				fs::remove(fPath);
+			});
+		}
+	});
+}
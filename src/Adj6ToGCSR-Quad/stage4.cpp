@@ -2,186 +2,111 @@
 #include "type.h"
 #include "util.h"
 
-#include <atomic>
-#include <chrono>
-#include <fstream>
-#include <iostream>
-#include <tbb/blocked_range.h>
+#include <GridCSR/Codec.h>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <string.h>
+#include <string>
 #include <tbb/parallel_for.h>
-#include <tbb/parallel_reduce.h>
-#include <tbb/parallel_scan.h>
-#include <tbb/parallel_sort.h>
 #include <thread>
-#include <valarray>
+#include <vector>
 
-static void writeCSR(fs::path const outTarget, sp<std::vector<E32>> in)
+// One pass over the sorted edges drops duplicates and fills .row/.ptr/.col together.
+// Each block counts its distinct edges and rows first; a scan over those per-block counts gives
+// every block its output offsets, so the only arrays left are the three outputs themselves.
+static void writeCSR(fs::path const outTarget, sp<std::vector<E32>> in, bool const compress)
 {
+	auto & el = *in;
 
-	auto fillRowAndPtr = std::thread([&, in] {
-		// fill
-		std::vector<std::atomic<uint32_t>> bitvec(size_t(ceil(double(in->size()) / 32.0)));
+	size_t const blocks	  = std::max(1U, std::thread::hardware_concurrency());
+	auto		 blockPos = [&](size_t const b) { return el.size() * b / blocks; };
 
-		auto getBit = [&bitvec](size_t const i) {
-			return (bitvec[i / 32].load() & (1 << (i % 32))) != 0;
-		};
-		auto setBit = [&bitvec](size_t const i) { bitvec[i / 32].fetch_or(1 << (i % 32)); };
+	auto newEdge = [&](size_t const i) { return i == 0 || el[i] != el[i - 1]; };
+	auto newRow	 = [&](size_t const i) { return i == 0 || el[i][0] != el[i - 1][0]; };
 
-		std::vector<uint64_t> pSumRes(in->size() + 1);
-
-		// prepare bit array
-		tbb::parallel_for(
-			tbb::blocked_range<size_t>(0, bitvec.size()),
-			[&](tbb::blocked_range<size_t> const & r) {
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto i = grain + offset;
-
-						bitvec[i] = 0;
-					}
-				}
-			},
-			tbb::auto_partitioner());
-
-		// prepare exclusive sum array
-		tbb::parallel_for(
-			tbb::blocked_range<size_t>(0, pSumRes.size()),
-			[&](tbb::blocked_range<size_t> const & r) {
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto i = grain + offset;
+	// per-block counts
+	std::vector<size_t> edgeOff(blocks + 1, 0), rowOff(blocks + 1, 0);
+	tbb::parallel_for(size_t(0), blocks, [&](size_t const b) {
+		size_t edges = 0, rows = 0;
+		for (size_t i = blockPos(b); i < blockPos(b + 1); i++) {
+			edges += newEdge(i) ? 1 : 0;
+			rows += newRow(i) ? 1 : 0;
+		}
+		edgeOff[b + 1] = edges;
+		rowOff[b + 1]  = rows;
+	});
 
-						pSumRes[i] = 0;
-					}
-				}
-			},
-			tbb::auto_partitioner());
+	// exclusive scan over the blocks
+	for (size_t b = 0; b < blocks; b++) {
+		edgeOff[b + 1] += edgeOff[b];
+		rowOff[b + 1] += rowOff[b];
+	}
 
-		// set bit 1 which is left != right (not the case: left == right)
-		std::atomic<uint64_t> ones;
-		ones.store(0);
-		tbb::parallel_for(
-			tbb::blocked_range<size_t>(1, in->size()),
-			[&](tbb::blocked_range<size_t> const & r) {
-				uint64_t myOnes = 0;
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto prev = grain + offset - 1;
-						auto curr = grain + offset;
-						if (in->at(prev)[0] != in->at(curr)[0]) {
-							setBit(curr);
-							myOnes++;
-						}
-					}
+	// .ptr entries are 32 bit unless the grid has 2^32 edges or more, filled in their final width
+	auto const			  ptrWide = (edgeOff[blocks] > std::numeric_limits<V32>::max());
+	std::vector<V32>	  row(rowOff[blocks]), col(edgeOff[blocks]), ptr32;
+	std::vector<uint64_t> ptr64;
+
+	auto fill = [&](auto & ptr) {
+		ptr.resize(rowOff[blocks] + 1);
+		tbb::parallel_for(size_t(0), blocks, [&](size_t const b) {
+			auto e = edgeOff[b];
+			auto r = rowOff[b];
+			for (size_t i = blockPos(b); i < blockPos(b + 1); i++) {
+				if (newRow(i)) {
+					row[r] = el[i][0];
+					ptr[r] = e;
+					r++;
 				}
-				ones.fetch_add(myOnes);
-			},
-			tbb::auto_partitioner());
-		setBit(0);
-		ones.fetch_add(1);
-
-		// exclusive sum
-		tbb::parallel_scan(
-			tbb::blocked_range<size_t>(0, in->size()),
-			0L, // very important! not be just '0'
-			[&](tbb::blocked_range<size_t> const & r, uint64_t sum, bool isFinalScan) {
-				auto temp = sum;
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto i = grain + offset;
-						temp += (getBit(i) ? 1 : 0);
-						if (isFinalScan) {
-							pSumRes[i + 1] = temp;
-						}
-					}
+				if (newEdge(i)) {
+					col[e] = el[i][1];
+					e++;
 				}
-				return temp;
-			},
-			[&](size_t const & l, size_t const & r) { return l + r; },
-			tbb::auto_partitioner());
-
-		////////////////
-		auto saveRow = std::thread([&] {
-			std::vector<V32> out(ones);
-
-			tbb::parallel_for(
-				tbb::blocked_range<size_t>(0, in->size()),
-				[&](tbb::blocked_range<size_t> const & r) {
-					for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-						for (size_t offset = 0; offset < r.grainsize(); offset++) {
-							auto i = grain + offset;
-
-							if (getBit(i)) {
-								out[pSumRes[i]] = in->at(i)[0];
-							}
-						}
-					}
-				},
-				tbb::auto_partitioner());
-			auto trueTarget = fs::path(outTarget.string() + ".row");
-			fileSave(trueTarget, out.data(), out.size() * sizeof(V32));
-		});
-
-		auto savePtr = std::thread([&] {
-			std::vector<V32> out(ones + 1);
-
-			tbb::parallel_for(
-				tbb::blocked_range<size_t>(0, in->size()),
-				[&](tbb::blocked_range<size_t> const & r) {
-					for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-						for (size_t offset = 0; offset < r.grainsize(); offset++) {
-							auto i = grain + offset;
-
-							if (getBit(i)) {
-								out[pSumRes[i]] = i;
-							}
-						}
-					}
-				},
-				tbb::auto_partitioner());
-			out.back()		= in->size();
-			auto trueTarget = fs::path(outTarget.string() + ".ptr");
-			fileSave(trueTarget, out.data(), out.size() * sizeof(V32));
+			}
 		});
+		ptr.back() = col.size();
+	};
+	if (ptrWide) {
+		fill(ptr64);
+	} else {
+		fill(ptr32);
+	}
 
-		if (saveRow.joinable()) {
-			saveRow.join();
-		}
-
-		if (savePtr.joinable()) {
-			savePtr.join();
-		}
-	});
-
-	auto fillCol = std::thread([&, in] {
-		// fill col
-		std::vector<V32> out(in->size());
-
-		tbb::parallel_for(
-			tbb::blocked_range<size_t>(0, in->size()),
-			[&](tbb::blocked_range<size_t> const & r) {
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto i = grain + offset;
-
-						out[i] = in->at(i)[1];
-					}
-				}
-			},
-			tbb::auto_partitioner());
-		auto trueTarget = fs::path(outTarget.string() + ".col");
-		fileSave(trueTarget, out.data(), out.size() * sizeof(V32));
-	});
+	// the encoded .col replaces the plain one
+	std::vector<uint8_t> code;
+	if (compress) {
+		GridCSR::ColEncoder encoder;
+		code.resize(GridCSR::colBound(col.size()));
+		code.resize(sizeof(GridCSR::ColHeader) +
+					encoder.put(col.data(), col.size(), &code[sizeof(GridCSR::ColHeader)]));
 
-	if (fillCol.joinable()) {
-		fillCol.join();
+		auto header = encoder.header();
+		memcpy(code.data(), &header, sizeof(header));
 	}
 
-	if (fillRowAndPtr.joinable()) {
-		fillRowAndPtr.join();
+	std::array<std::string, 3>	ext	 = {".row", ".ptr", ".col"};
+	std::array<void const *, 3> data = {row.data(), ptr32.data(), col.data()};
+	std::array<size_t, 3>		byte = {
+		  row.size() * sizeof(V32), ptr32.size() * sizeof(V32), col.size() * sizeof(V32)};
+	if (ptrWide) {
+		data[1] = ptr64.data();
+		byte[1] = ptr64.size() * sizeof(uint64_t);
+	}
+	if (compress) {
+		data[2] = code.data();
+		byte[2] = code.size();
 	}
+
+	parallelDo(3, [&](size_t const i) {
+		auto trueTarget = fs::path(outTarget.string() + ext[i]);
+		auto partTarget = fs::path(trueTarget.string() + __PARTEXT);
+		fileSave(partTarget, data[i], byte[i]);
+		fileCommit(partTarget, trueTarget);
+	});
 }
 
-void stage4(fs::path const & outFolder)
+void stage4(fs::path const & outFolder, bool const compress, Manifest & manifest)
 {
 	auto jobs = [&] {
 		auto out = makeSp<bchan<fs::path>>(16);
@@ -198,9 +123,12 @@ void stage4(fs::path const & outFolder)
 	parallelDo(8, [&](size_t const i) {
 		for (auto & fPath : *jobs) {
 			stopwatch("Stage4, " + std::string(fPath), [&] {
-				auto rawData = fileLoad<E32>(fPath);
-				auto target	 = fPath.parent_path() / fPath.stem();
-				writeCSR(target, rawData);
+				auto stem = fPath.stem().string();
+				if (!manifest.done("Stage4", stem)) {
+					auto target = fPath.parent_path() / fPath.stem();
+					writeCSR(target, edgeLoad(fPath), compress);
+					manifest.finish("Stage4", stem);
+				}
 				fs::remove(fPath);
 			});
 		}
@@ -5,6 +5,7 @@
 #include <atomic>
 #include <boost/fiber/all.hpp>
 #include <memory>
+#include <string>
 #include <stdint.h>
 
 #if __GNUC__ < 8
@@ -29,20 +30,23 @@ struct RowPos {
 	size_t src, cnt, dstStart;
 };
 
-struct Reorder {
-	uint64_t key, val;
-	/*
-		std::atomic<uint64_t> key, val;
-
-		Reorder() : key(), val() {}
-		Reorder(Reorder const & a) : key(a.key.load()), val(a.val.load()) {}
-		Reorder & operator=(Reorder const & other)
-		{
-			key.store(other.key.load());
-			val.store(other.val.load());
-			return *this;
-		}
-		*/
+// [begin, end) byte range of an Adj6 file that holds whole rows
+struct RowBlock {
+	size_t begin, end;
+};
+
+// Name of a Stage3 shard: "<row>-<col>" for a whole grid, then ",<depth>,<sr>-<sc>" once it is
+// split, then ",<rs>-<rt>,<cs>-<ct>" when the split was edge-balanced rather than midpoint.
+struct ShardIndex {
+	std::array<V32, 2>				   grid, shard;
+	uint32_t						   depth;
+	bool							   ranged; // edge-balanced shards carry their local ranges
+	std::array<std::array<V32, 2>, 2> range;  // [row_s,row_t),[col_s,col_t) within the grid
+	std::string						   string() const;
+	bool							   parse(std::string const & in);
+
+	// local ranges of the shard in a grid of the given width, also for midpoint shards
+	std::array<std::array<V32, 2>, 2> span(uint32_t const width) const;
 };
 
 #endif /* CA0B2FF9_2C71_4DD4_927B_AB0FDD3FD13F */
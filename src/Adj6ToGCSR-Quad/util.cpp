@@ -1,14 +1,26 @@
 #include "util.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <mutex>
+#include <regex>
 #include <sstream>
 #include <stdio.h>
+#include <sys/mman.h>
 //#include <tbb/blocked_range.h>
 //#include <tbb/parallel_for.h>
 //#include <tbb/task_arena.h>
 #include <thread>
+#include <unistd.h>
+
+// pick the simdpp backend from the target flags; without SSSE3 be6_le8_bulk() stays scalar
+#if defined(__AVX2__)
+#define SIMDPP_ARCH_X86_AVX2
+#elif defined(__SSSE3__)
+#define SIMDPP_ARCH_X86_SSSE3
+#endif
+#include <simdpp/simd.h>
 
 static std::mutex __logMtx;
 
@@ -58,7 +70,7 @@ void stopwatch(std::string const & message, std::function<void()> function)
 	}
 }
 
-uint64_t be6_le8(uint8_t * in)
+uint64_t be6_le8(uint8_t const * in)
 {
 	uint64_t out = 0;
 	out |= in[0];
@@ -69,6 +81,117 @@ uint64_t be6_le8(uint8_t * in)
 	return out;
 }
 
+void be6_le8_bulk(uint8_t const * in, uint64_t * out, size_t const count)
+{
+	size_t i = 0;
+#if SIMDPP_USE_SSSE3
+	// each 128-bit lane byte-swaps two 6-byte IDs into the low bytes of two uint64_t and zeroes
+	// the top two bytes; the two lanes are loaded 12 bytes apart so one step decodes four IDs.
+	// a step reads 28 bytes, so stop while at least one more ID follows to stay inside the row.
+	simdpp::uint8<32> const mask =
+		simdpp::make_uint(5, 4, 3, 2, 1, 0, 0x80, 0x80, 11, 10, 9, 8, 7, 6, 0x80, 0x80);
+
+	for (; i + 5 <= count; i += 4) {
+		auto const		  p	 = &in[i * 6];
+		simdpp::uint8<16> lo = simdpp::load_u(p);
+		simdpp::uint8<16> hi = simdpp::load_u(p + 12);
+		simdpp::uint8<32> le = simdpp::permute_zbytes16(simdpp::combine(lo, hi), mask);
+		simdpp::store_u(&out[i], le);
+	}
+#endif
+	for (; i < count; i++) {
+		out[i] = be6_le8(&in[i * 6]);
+	}
+}
+
+void pack24_bulk(E32 const * in, uint8_t * out, size_t const count)
+{
+	size_t i = 0;
+#if SIMDPP_USE_SSSE3
+	// each 128-bit lane drops the zero top byte of four local IDs (two edges, 16 -> 12 bytes).
+	// the lanes are stored 12 bytes apart and each store spills 4 bytes past its 12, so keep one
+	// more edge behind the step for the last store to land on.
+	simdpp::uint8<32> const mask =
+		simdpp::make_uint(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0x80, 0x80, 0x80, 0x80);
+
+	for (; i + 5 <= count; i += 4) {
+		auto const		  p = &out[i * 6];
+		simdpp::uint8<32> le;
+		le = simdpp::load_u((uint8_t const *)&in[i]);
+		le = simdpp::permute_zbytes16(le, mask);
+
+		simdpp::uint8<16> lo, hi;
+		simdpp::split(le, lo, hi);
+		simdpp::store_u(p, lo);
+		simdpp::store_u(p + 12, hi);
+	}
+#endif
+	for (; i < count; i++) {
+		for (size_t j = 0; j < 2; j++) {
+			out[i * 6 + j * 3 + 0] = uint8_t(in[i][j]);
+			out[i * 6 + j * 3 + 1] = uint8_t(in[i][j] >> 8);
+			out[i * 6 + j * 3 + 2] = uint8_t(in[i][j] >> 16);
+		}
+	}
+}
+
+void unpack24_bulk(uint8_t const * in, E32 * out, size_t const count)
+{
+	size_t i = 0;
+#if SIMDPP_USE_SSSE3
+	// the reverse of pack24_bulk(): lanes loaded 12 bytes apart, each widens two edges; a step
+	// reads 28 bytes, so stop while at least one more edge follows.
+	simdpp::uint8<32> const mask =
+		simdpp::make_uint(0, 1, 2, 0x80, 3, 4, 5, 0x80, 6, 7, 8, 0x80, 9, 10, 11, 0x80);
+
+	for (; i + 5 <= count; i += 4) {
+		auto const		  p	 = &in[i * 6];
+		simdpp::uint8<16> lo = simdpp::load_u(p);
+		simdpp::uint8<16> hi = simdpp::load_u(p + 12);
+		simdpp::uint8<32> le = simdpp::permute_zbytes16(simdpp::combine(lo, hi), mask);
+		simdpp::store_u(&out[i], le);
+	}
+#endif
+	for (; i < count; i++) {
+		for (size_t j = 0; j < 2; j++) {
+			auto const p = &in[i * 6 + j * 3];
+			out[i][j]	 = V32(p[0]) | (V32(p[1]) << 8) | (V32(p[2]) << 16);
+		}
+	}
+}
+
+void edgeWrite(int const fp, E32 const * data, size_t const count)
+{
+#ifdef __PACK24
+	static thread_local std::vector<uint8_t> packed;
+	packed.resize(count * __EDGEBYTE);
+	pack24_bulk(data, packed.data(), count);
+	fileWrite(fp, packed.data(), packed.size());
+#else
+	fileWrite(fp, data, count * sizeof(E32));
+#endif
+}
+
+void edgeSave(fs::path const & path, E32 const * data, size_t const count)
+{
+	auto fp = open64(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	assert_errno(fp >= 0);
+	edgeWrite(fp, data, count);
+	close(fp);
+}
+
+sp<std::vector<E32>> edgeLoad(fs::path const & path)
+{
+	auto in	 = fileMap(path);
+	auto out = makeSp<std::vector<E32>>(in->byte / __EDGEBYTE);
+#ifdef __PACK24
+	unpack24_bulk(in->addr, out->data(), out->size());
+#else
+	memcpy(out->data(), in->addr, in->byte);
+#endif
+	return out;
+}
+
 sp<bchan<fs::path>>
 fileListOver(fs::path const & folder, std::string const & extension, size_t const over)
 {
@@ -76,8 +199,10 @@ fileListOver(fs::path const & folder, std::string const & extension, size_t cons
 	std::thread([=] {
 		// recursive iteration
 		for (fs::recursive_directory_iterator iter(folder), end; iter != end; iter++) {
-			// check file is not directory and size is not zero
-			if (fs::is_regular_file(iter->status()) && fs::file_size(iter->path()) > over) {
+			// check file is not directory and size is not zero; skip files removed meanwhile
+			std::error_code ec;
+			auto			byte = fs::file_size(iter->path(), ec);
+			if (fs::is_regular_file(iter->status()) && !ec && byte > over) {
 				if (extension != "" && extension != iter->path().extension()) {
 					continue;
 				}
@@ -96,12 +221,19 @@ sp<bchan<fs::path>> fileList(fs::path const & folder, std::string const & extens
 	std::thread([=] {
 		// recursive iteration
 		for (fs::recursive_directory_iterator iter(folder), end; iter != end; iter++) {
-			// check file is not directory and size is not zero
-			if (fs::is_regular_file(iter->status()) && fs::file_size(iter->path()) != 0) {
+			// check file is not directory and size is not zero; skip files removed meanwhile
+			std::error_code ec;
+			auto			byte = fs::file_size(iter->path(), ec);
+			if (fs::is_regular_file(iter->status()) && !ec && byte != 0) {
 				if (extension != "" && extension != iter->path().extension()) {
 					continue;
 				}
 
+				// row block sidecars older converters left next to the Adj6 files
+				if (extension == "" && iter->path().extension() == __ADJ6IDX) {
+					continue;
+				}
+
 				out->push(fs::absolute(iter->path()));
 			}
 		}
@@ -110,30 +242,275 @@ sp<bchan<fs::path>> fileList(fs::path const & folder, std::string const & extens
 	return out;
 }
 
-sp<bchan<RowPos>> splitAdj6(sp<std::vector<uint8_t>> adj6)
+FileView::~FileView()
 {
-	auto out = makeSp<bchan<RowPos>>(16);
+	if (this->mapped) {
+		munmap((void *)this->addr, this->byte);
+	}
+}
+
+sp<FileView> fileMap(fs::path const & path)
+{
+	auto out	= makeSp<FileView>();
+	out->path	= path;
+	out->byte	= fs::file_size(path);
+	out->mapped = false;
+
+	auto fp = open64(path.c_str(), O_RDONLY);
+	assert_errno(fp >= 0);
+
+	int flags = MAP_PRIVATE;
+#ifdef __MMAP_POPULATE
+	flags |= MAP_POPULATE;
+#endif
+
+	auto addr = mmap64(nullptr, out->byte, PROT_READ, flags, fp, 0);
+	close(fp);
+
+	if (addr != MAP_FAILED) {
+		// rows are parsed front to back, so let the kernel read ahead as far as it can
+		madvise(addr, out->byte, MADV_SEQUENTIAL);
+		madvise(addr, out->byte, MADV_WILLNEED);
+		out->addr	= (uint8_t const *)addr;
+		out->mapped = true;
+	} else {
+		auto p		= fs::path(path);
+		out->buffer = fileLoad<uint8_t>(p);
+		out->addr	= out->buffer->data();
+	}
+
+	return out;
+}
+
+sp<bchan<sp<FileView>>> fileMapList(sp<bchan<fs::path>> in)
+{
+	// the file mapped here waits in the channel while the consumers work on the current ones,
+	// so its readahead (or MAP_POPULATE) overlaps with parsing
+	auto out = makeSp<bchan<sp<FileView>>>(2);
 	std::thread([=] {
-		for (size_t i = 0; i < adj6->size();) {
-			RowPos rPos;
-			rPos.src = be6_le8(&(adj6->at(i)));
-			i += 6;
-			rPos.cnt = be6_le8(&(adj6->at(i)));
-			i += 6;
-			rPos.dstStart = i;
-			out->push(rPos);
-			i += (6 * rPos.cnt);
+		for (auto & path : *in) {
+			out->push(fileMap(path));
 		}
 		out->close();
 	}).detach();
 	return out;
 }
 
+struct Adj6Index {
+	uint64_t magic, fileByte, fileTime, blockByte, blocks;
+	uint64_t pathByte; // the input's absolute path follows, then the blocks
+};
+
+static uint64_t const __ADJ6IDX_MAGIC = 0x32786449366a6441; // "Adj6Idx2"
+
+static uint64_t lastWriteTime(fs::path const & path)
+{
+	return uint64_t(fs::last_write_time(path).time_since_epoch().count());
+}
+
+// the index of an input lives below the output, named after a hash of the input's path; the
+// path, size and mtime inside tell whether it still describes that file
+static fs::path adj6IndexPath(FileView const & adj6, fs::path const & outFolder)
+{
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0')
+		 << std::hash<std::string>{}(fs::absolute(adj6.path).string()) << __ADJ6IDX;
+	return outFolder / __BLOCKDIR / name.str();
+}
+
+// blocks of a previous run, if the index still describes this very file
+static bool
+loadAdj6Index(FileView const & adj6, fs::path const & idxPath, std::vector<RowBlock> & blocks)
+{
+	std::error_code ec;
+	if (!fs::exists(idxPath, ec)) {
+		return false;
+	}
+
+	auto idxFile = idxPath;
+	auto raw	 = fileLoad<uint8_t>(idxFile);
+	if (raw->size() < sizeof(Adj6Index)) {
+		return false;
+	}
+
+	auto idx  = (Adj6Index const *)raw->data();
+	auto path = fs::absolute(adj6.path).string();
+	if (idx->magic != __ADJ6IDX_MAGIC || idx->fileByte != adj6.byte ||
+		idx->fileTime != lastWriteTime(adj6.path) || idx->blockByte != __ADJ6BLOCK ||
+		idx->pathByte != path.size() ||
+		raw->size() != sizeof(Adj6Index) + idx->pathByte + idx->blocks * sizeof(RowBlock) ||
+		memcmp(idx + 1, path.data(), path.size()) != 0) {
+		return false;
+	}
+
+	auto first = (RowBlock const *)((uint8_t const *)(idx + 1) + idx->pathByte);
+	blocks.assign(first, first + idx->blocks);
+	return true;
+}
+
+static void saveAdj6Index(FileView const &				adj6,
+						  fs::path const &				idxPath,
+						  std::vector<RowBlock> const & blocks)
+{
+	auto tmpPath = fs::path(idxPath.string() + ".tmp");
+	auto path	 = fs::absolute(adj6.path).string();
+
+	Adj6Index idx;
+	idx.magic	  = __ADJ6IDX_MAGIC;
+	idx.fileByte  = adj6.byte;
+	idx.fileTime  = lastWriteTime(adj6.path);
+	idx.blockByte = __ADJ6BLOCK;
+	idx.blocks	  = blocks.size();
+	idx.pathByte  = path.size();
+
+	std::error_code ec;
+	fs::create_directories(idxPath.parent_path(), ec);
+
+	auto fp = open64(tmpPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	if (fp < 0) {
+		log("cannot save the row block index " + idxPath.string() + ": " + strerror(errno));
+		return;
+	}
+
+	auto blockByte = ssize_t(blocks.size() * sizeof(RowBlock));
+	auto ok		   = write(fp, &idx, sizeof(idx)) == ssize_t(sizeof(idx)) &&
+			  write(fp, path.data(), path.size()) == ssize_t(path.size()) &&
+			  write(fp, blocks.data(), blockByte) == blockByte;
+	close(fp);
+
+	if (ok) {
+		fs::rename(tmpPath, idxPath, ec);
+	} else {
+		fs::remove(tmpPath, ec);
+	}
+}
+
+sp<bchan<RowBlock>> splitAdj6(sp<FileView> adj6, fs::path const & outFolder)
+{
+	auto out = makeSp<bchan<RowBlock>>(16);
+	std::thread([=] {
+		std::vector<RowBlock> blocks;
+
+		auto idxPath = adj6IndexPath(*adj6, outFolder);
+		if (loadAdj6Index(*adj6, idxPath, blocks)) {
+			for (auto & blk : blocks) {
+				out->push(blk);
+			}
+			out->close();
+			return;
+		}
+
+		// only hop from row header to row header; the mappers parse their blocks themselves
+		RowBlock blk = {0, 0};
+		for (size_t i = 0; i + 12 <= adj6->byte;) {
+			i += 12 + 6 * be6_le8(&adj6->addr[i + 6]);
+
+			if (i - blk.begin >= __ADJ6BLOCK || i + 12 > adj6->byte) {
+				blk.end = (i < adj6->byte) ? i : adj6->byte;
+				out->push(blk);
+				blocks.push_back(blk);
+				blk.begin = blk.end;
+			}
+		}
+		out->close();
+
+		saveAdj6Index(*adj6, idxPath, blocks);
+	}).detach();
+	return out;
+}
+
 std::string fileNameEncode(E32 const & grid, std::string const & ext)
 {
 	return std::to_string(grid[0]) + "-" + std::to_string(grid[1]) + ext;
 }
 
+std::string ShardIndex::string() const
+{
+	if (this->depth > 0 && this->ranged) {
+		return std::to_string(this->grid[0]) + "-" + std::to_string(this->grid[1]) + "," +
+			   std::to_string(this->depth) + "," + std::to_string(this->shard[0]) + "-" +
+			   std::to_string(this->shard[1]) + "," + std::to_string(this->range[0][0]) + "-" +
+			   std::to_string(this->range[0][1]) + "," + std::to_string(this->range[1][0]) +
+			   "-" + std::to_string(this->range[1][1]);
+	} else if (this->depth > 0) {
+		return std::to_string(this->grid[0]) + "-" + std::to_string(this->grid[1]) + "," +
+			   std::to_string(this->depth) + "," + std::to_string(this->shard[0]) + "-" +
+			   std::to_string(this->shard[1]);
+	} else {
+		return std::to_string(this->grid[0]) + "-" + std::to_string(this->grid[1]);
+	}
+}
+
+bool ShardIndex::parse(std::string const & in)
+{
+	*this = {
+		0,
+	};
+
+	std::regex	regex(
+		"^(\\d*)-(\\d*)(?:,(\\d*),(\\d*)-(\\d*)(?:,(\\d*)-(\\d*),(\\d*)-(\\d*))?)?$");
+	std::smatch m;
+
+	if (std::regex_match(in, m, regex)) {
+		if (m[1].length() > 0) {
+			this->grid[0] = strtol(std::string(m[1]).c_str(), nullptr, 10);
+		}
+
+		if (m[2].length() > 0) {
+			this->grid[1] = strtol(std::string(m[2]).c_str(), nullptr, 10);
+		}
+
+		if (m[3].length() > 0) {
+			this->depth = strtol(std::string(m[3]).c_str(), nullptr, 10);
+		} else {
+			return true;
+		}
+
+		if (m[4].length() > 0) {
+			this->shard[0] = strtol(std::string(m[4]).c_str(), nullptr, 10);
+		} else {
+		}
+
+		if (m[5].length() > 0) {
+			this->shard[1] = strtol(std::string(m[5]).c_str(), nullptr, 10);
+		} else {
+		}
+
+		if (m[6].length() > 0 && m[7].length() > 0 && m[8].length() > 0 && m[9].length() > 0) {
+			this->ranged	  = true;
+			this->range[0][0] = strtol(std::string(m[6]).c_str(), nullptr, 10);
+			this->range[0][1] = strtol(std::string(m[7]).c_str(), nullptr, 10);
+			this->range[1][0] = strtol(std::string(m[8]).c_str(), nullptr, 10);
+			this->range[1][1] = strtol(std::string(m[9]).c_str(), nullptr, 10);
+		}
+
+		return true;
+	} else {
+		return false;
+	}
+}
+
+std::array<std::array<V32, 2>, 2> ShardIndex::span(uint32_t const width) const
+{
+	if (this->ranged) {
+		return this->range;
+	}
+
+	// follow the midpoint cuts of Stage3 from the whole grid down, one shard bit per level
+	std::array<std::array<V32, 2>, 2> out = {{{0, width}, {0, width}}};
+	for (size_t i = 0; i < out.size(); i++) {
+		for (auto d = this->depth; d > 0; d--) {
+			auto mid = out[i][0] + (out[i][1] - out[i][0]) / 2;
+			if ((this->shard[i] >> (d - 1)) & 1) {
+				out[i][0] = mid;
+			} else {
+				out[i][1] = mid;
+			}
+		}
+	}
+	return out;
+}
+
 void parallelDo(size_t const workers, std::function<void(size_t const)> func)
 {
 	/*
@@ -156,4 +533,27 @@ void parallelDo(size_t const workers, std::function<void(size_t const)> func)
 			wlist[i].join();
 		}
 	}
-}
\ No newline at end of file
+}
+
+std::unordered_map<std::string, std::string> parseOptions(int & argc, char * argv[])
+{
+	std::unordered_map<std::string, std::string> out;
+
+	int positional = 0;
+	for (int i = 0; i < argc; i++) {
+		auto arg = std::string(argv[i]);
+		if (i > 0 && arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+			auto eq = arg.find('=');
+			if (eq == std::string::npos) {
+				out[arg.substr(2)] = "";
+			} else {
+				out[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+			}
+		} else {
+			argv[positional++] = argv[i];
+		}
+	}
+	argc = positional;
+
+	return out;
+}
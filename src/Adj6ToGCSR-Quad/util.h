@@ -22,16 +22,44 @@
 
 #include <fcntl.h>
 #include <functional>
+#include <mutex>
 #include <string>
-
-#define __CDEF (1L << 27) // 128MB
+#include <unordered_map>
+#include <vector>
+
+#define __CDEF		(1L << 27) // 128MB
+#define __ADJ6BLOCK (1L << 20) // 1MB of Adj6 rows per mapper job
+#define __ADJ6IDX	".idx"	   // row block index of an Adj6 file, see splitAdj6()
+#define __BLOCKDIR	"adj6idx"  // folder of the row block indexes, below the output folder
+//#define __MMAP_POPULATE // fault in the whole input file at mmap() time (MAP_POPULATE)
+#define __PACK24 // intermediate .el32 edges as two 24-bit local IDs; needs gridWidth <= 1 << 24
+
+#ifdef __PACK24
+#define __EDGEBYTE 6 // bytes per intermediate edge
+#else
+#define __EDGEBYTE 8
+#endif
+
+// read-only view of a whole input file, mmap()ed when possible and read() otherwise
+struct FileView {
+	fs::path				 path;
+	uint8_t const *			 addr;
+	size_t					 byte;
+	bool					 mapped;
+	sp<std::vector<uint8_t>> buffer;
+
+	~FileView();
+};
 
 // user interface for testing
 void log(std::string const & s);
 void stopwatch(std::string const & message, std::function<void()> function);
 
 // data conversion and calculation
-uint64_t be6_le8(uint8_t * in);
+uint64_t be6_le8(uint8_t const * in);
+void	 be6_le8_bulk(uint8_t const * in, uint64_t * out, size_t const count);
+void	 pack24_bulk(E32 const * in, uint8_t * out, size_t const count);
+void	 unpack24_bulk(uint8_t const * in, E32 * out, size_t const count);
 size_t	 ceil(size_t const x, size_t const y);
 
 // file and folder
@@ -39,13 +67,45 @@ sp<bchan<fs::path>> fileList(fs::path const & folder, std::string const & extens
 sp<bchan<fs::path>>
 			fileListOver(fs::path const & folder, std::string const & extension, size_t const over);
 std::string fileNameEncode(E32 const & grid, std::string const & ext);
+sp<FileView> fileMap(fs::path const & path);
+sp<bchan<sp<FileView>>> fileMapList(sp<bchan<fs::path>> in);
+
+// intermediate edge lists, in the __PACK24 layout when enabled
+void				 edgeWrite(int const fp, E32 const * data, size_t const count);
+void				 edgeSave(fs::path const & path, E32 const * data, size_t const count);
+sp<std::vector<E32>> edgeLoad(fs::path const & path);
 
 // parser
-sp<bchan<RowPos>> splitAdj6(sp<std::vector<uint8_t>> adj6);
+sp<bchan<RowBlock>> splitAdj6(sp<FileView> adj6, fs::path const & outFolder);
 
 // parallelism
 void parallelDo(size_t workers, std::function<void(size_t)> func);
 
+// "--key=value" and "--key" arguments, removed from argv so positional parsing sees the rest
+std::unordered_map<std::string, std::string> parseOptions(int & argc, char * argv[]);
+
+// calls func(RowPos const &) for every row of blk
+template <typename Func>
+void forEachRow(FileView const & adj6, RowBlock const & blk, Func func)
+{
+	for (size_t i = blk.begin; i + 12 <= blk.end;) {
+		RowPos rPos;
+		rPos.src = be6_le8(&adj6.addr[i]);
+		i += 6;
+		rPos.cnt = be6_le8(&adj6.addr[i]);
+		i += 6;
+		rPos.dstStart = i;
+		i += (6 * rPos.cnt);
+
+		// truncated row at the end of the file
+		if (i > blk.end) {
+			break;
+		}
+
+		func(rPos);
+	}
+}
+
 template <typename T>
 auto fileSave(fs::path & path, T * data, size_t byte)
 {
@@ -63,6 +123,18 @@ auto fileSave(fs::path & path, T * data, size_t byte)
 	close(fp);
 }
 
+// writes byte bytes of data to an already open descriptor
+template <typename T>
+void fileWrite(int const fp, T const * data, size_t const byte)
+{
+	uint64_t pos = 0;
+	while (pos < byte) {
+		auto b = write(fp, &(((uint8_t const *)data)[pos]), byte - pos);
+		assert_errno(b >= 0);
+		pos += b;
+	}
+}
+
 template <typename T>
 auto fileSaveAppend(fs::path & path, T * data, size_t byte)
 {
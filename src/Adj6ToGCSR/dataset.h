@@ -0,0 +1,50 @@
+#ifndef AB63873E_ACB6_4E3B_A6F7_93EF96E07416
+#define AB63873E_ACB6_4E3B_A6F7_93EF96E07416
+
+#include "type.h"
+
+#include <string>
+#include <unordered_map>
+
+#define __GRIDBYTE	 (1L << 28)	 // .col bytes a grid is sized for when the width is chosen
+#define __GRIDMINEXP 12
+#define __GRIDMAXEXP 24			 // local IDs stay within 24 bits, see __PACK24
+#define __METAFILE	 "meta.json" // GridCSR::MetaData of the output folder
+#define __PACKEXT	 ".gcsr"	 // GridCSR::Pack container of a whole dataset
+#define __ROWIDXEXT	 ".ridx"	 // GridCSR::RowIndex of a grid, next to its .row
+#define __TRANSPOSED "transpose" // dataset of the transposed grids, see --transpose
+#define __DELTADIR	 "delta"	 // folder of the deltas of a dataset, see --append
+
+// grid width and output metadata, see GridCSR::MetaData
+uint64_t inputEdges(fs::path const & inFolder);
+uint32_t gridWidthSelect(std::unordered_map<std::string, std::string> & options,
+						 uint64_t const								  vertices,
+						 uint64_t const								  edges);
+void	 metaSave(fs::path const &	  folder,
+				  std::string const & name,
+				  uint32_t const	  width,
+				  uint64_t const	  maxVID,
+				  bool const		  compress,
+				  bool const		  index,
+				  std::string const & orientation,
+				  std::string const & transpose);
+
+// writes the row index of every grid in the folder, see GridCSR/RowIndex.h
+void indexSave(fs::path const & folder, uint32_t const width);
+
+// --append: the folder of the next delta of the dataset in folder, relative to it; one an
+// interrupted append left unlisted is taken again, and started over unless resuming
+std::string deltaSelect(fs::path const & folder, bool const resume);
+
+// --append: the largest vertex ID in the input, read once to check it against the dataset's
+// relabel table before a delta is started; Adj6 block indexes go below outFolder
+uint64_t inputMaxVID(fs::path const & inFolder, fs::path const & outFolder);
+
+// lists a finished delta in the dataset's metadata, which makes readers merge it
+void deltaAppend(fs::path const & folder, std::string const & name);
+
+// moves every grid listed in the metadata into one GridCSR::Pack container, segments aligned to
+// 2^alignExp bytes, and removes the grid files
+void packSave(fs::path const & folder, std::string const & name, size_t const alignExp);
+
+#endif /* AB63873E_ACB6_4E3B_A6F7_93EF96E07416 */
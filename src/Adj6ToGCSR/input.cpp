@@ -0,0 +1,242 @@
+#include "input.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string.h>
+#include <thread>
+
+// pick the simdpp backend from the target flags; without SSE2 the text scan stays scalar
+#if defined(__AVX2__)
+#define SIMDPP_ARCH_X86_AVX2
+#elif defined(__SSSE3__)
+#define SIMDPP_ARCH_X86_SSSE3
+#elif defined(__SSE2__)
+#define SIMDPP_ARCH_X86_SSE2
+#endif
+#include <simdpp/simd.h>
+
+InputFormat inputFormat(fs::path const & path)
+{
+	auto ext = path.extension();
+	if (ext == ".mtx") {
+		return InputFormat::MatrixMarket;
+	}
+	if (ext == ".tsv" || ext == ".csv" || ext == ".txt" || ext == ".el" || ext == ".edges") {
+		return InputFormat::EdgeList;
+	}
+	return InputFormat::Adj6;
+}
+
+// offset just past the first '\n' at or after pos, byte if there is none
+static size_t lineEnd(uint8_t const * addr, size_t const pos, size_t const byte)
+{
+	auto nl = (uint8_t const *)memchr(&addr[pos], '\n', byte - pos);
+	return (nl != nullptr) ? size_t(nl - addr) + 1 : byte;
+}
+
+static sp<bchan<RowBlock>> splitText(sp<FileView> text, InputFormat const format)
+{
+	auto out = makeSp<bchan<RowBlock>>(16);
+	std::thread([=] {
+		auto addr  = text->addr;
+		auto byte  = text->byte;
+		auto begin = size_t(0);
+
+		// the size line of a Matrix Market file follows its comments and is not an edge
+		if (format == InputFormat::MatrixMarket) {
+			while (begin < byte && addr[begin] == '%') {
+				begin = lineEnd(addr, begin, byte);
+			}
+			begin = lineEnd(addr, begin, byte);
+		}
+
+		// no sidecar as for Adj6; finding a line end every block is a single memchr()
+		while (begin < byte) {
+			auto end = (byte - begin > __TEXTBLOCK) ? lineEnd(addr, begin + __TEXTBLOCK, byte)
+													: byte;
+			out->push(RowBlock{begin, end});
+			begin = end;
+		}
+		out->close();
+	}).detach();
+	return out;
+}
+
+sp<bchan<RowBlock>> splitInput(sp<FileView> in, fs::path const & outFolder)
+{
+	auto format = inputFormat(in->path);
+	return (format == InputFormat::Adj6) ? splitAdj6(in, outFolder) : splitText(in, format);
+}
+
+static bool isDigit(uint8_t const c) { return uint8_t(c - '0') < 10; }
+static bool isSeparator(uint8_t const c) { return c == ' ' || c == '\t' || c == ','; }
+
+#if SIMDPP_USE_SSE2
+using Byte16 = simdpp::uint8<16>;
+
+// bit i is set when c[i] is a digit
+static uint32_t digitBits(Byte16 const & c)
+{
+	Byte16 d = simdpp::sub(c, simdpp::splat<Byte16>('0'));
+	auto   m = simdpp::cmp_eq(simdpp::min(d, simdpp::splat<Byte16>(9)), d);
+	return simdpp::extract_bits_any(Byte16(m));
+}
+
+// bit i is set when c[i] is a separator
+static uint32_t separatorBits(Byte16 const & c)
+{
+	auto space = simdpp::cmp_eq(c, simdpp::splat<Byte16>(' '));
+	auto tab   = simdpp::cmp_eq(c, simdpp::splat<Byte16>('\t'));
+	auto comma = simdpp::cmp_eq(c, simdpp::splat<Byte16>(','));
+
+	// a stored bit_or() expression would refer to temporaries; evaluate it in one go
+	Byte16 m = simdpp::bit_or(simdpp::bit_or(Byte16(space), Byte16(tab)), Byte16(comma));
+	return simdpp::extract_bits_any(m);
+}
+#endif
+
+// first byte in [p, end) that is no separator, end if there is none
+static uint8_t const * skipSeparators(uint8_t const * p, uint8_t const * const end)
+{
+	// mostly a single tab, comma or space
+	if (p < end && !isSeparator(*p)) {
+		return p;
+	}
+#if SIMDPP_USE_SSE2
+	for (; p + 16 <= end; p += 16) {
+		auto other = uint16_t(~separatorBits(simdpp::load_u(p)));
+		if (other != 0) {
+			return p + __builtin_ctz(other);
+		}
+	}
+#endif
+	while (p < end && isSeparator(*p)) {
+		p++;
+	}
+	return p;
+}
+
+// the n (1 to 8) digits at p as a number; eight bytes at p must be readable
+static uint64_t digits8(uint8_t const * p, size_t const n)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+
+	// the digits sit in the low bytes and never borrow, the bytes after them are shifted out
+	v -= 0x3030303030303030ULL;
+	v <<= 8 * (8 - n);
+
+	// SWAR: pairs, then quads, then all eight digits
+	v = (v * 10) + (v >> 8);
+	return (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+			(((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >>
+		   32;
+}
+
+// the number starting at the digit p; returns the first byte after it
+static uint8_t const * parseNumber(uint8_t const * p, uint8_t const * const end, uint64_t & value)
+{
+#if SIMDPP_USE_SSE2
+	// up to 15 digits at once, longer numbers and the tail of the block go byte by byte
+	if (p + 16 <= end) {
+		auto other = uint16_t(~digitBits(simdpp::load_u(p)));
+		if (other != 0) {
+			auto n = size_t(__builtin_ctz(other));
+			value  = (n <= 8) ? digits8(p, n)
+							  : digits8(p, n - 8) * 100000000ULL + digits8(p + n - 8, 8);
+			return p + n;
+		}
+	}
+#endif
+	value = 0;
+	for (; p < end && isDigit(*p); p++) {
+		value = value * 10 + (*p - '0');
+	}
+	return p;
+}
+
+// whether the banner of a Matrix Market file stores one triangle for both: symmetric,
+// skew-symmetric or hermitian
+static bool mtxSymmetric(FileView const & text)
+{
+	auto byte	= std::min(text.byte, size_t(1024));
+	auto nl		= (uint8_t const *)memchr(text.addr, '\n', byte);
+	auto banner = std::string((char const *)text.addr, (nl != nullptr) ? nl - text.addr : byte);
+	std::transform(banner.begin(), banner.end(), banner.begin(), ::tolower);
+
+	std::istringstream words(banner);
+	std::string		   word, symmetry;
+	if (!(words >> word) || word != "%%matrixmarket") {
+		return false;
+	}
+	while (words >> word) {
+		symmetry = word;
+	}
+	return symmetry == "symmetric" || symmetry == "skew-symmetric" || symmetry == "hermitian";
+}
+
+// a line that starts like an edge but is none; dropping it would lose edges unnoticed
+static void malformed(FileView const & text, uint8_t const * line)
+{
+	auto rest = size_t(text.addr + text.byte - line);
+	auto nl	  = (uint8_t const *)memchr(line, '\n', rest);
+	auto len  = std::min((nl != nullptr) ? size_t(nl - line) : rest, size_t(80));
+	fprintf(stderr,
+			"malformed edge at byte %zu of %s: %.*s\n",
+			size_t(line - text.addr),
+			text.path.c_str(),
+			int(len),
+			(char const *)line);
+	exit(EXIT_FAILURE);
+}
+
+void textDecode(FileView const &					  text,
+				RowBlock const &					  blk,
+				InputFormat const					  format,
+				std::vector<std::array<uint64_t, 2>> & out)
+{
+	uint64_t const base	  = (format == InputFormat::MatrixMarket) ? 1 : 0;
+	auto const	   mirror = (format == InputFormat::MatrixMarket) && mtxSymmetric(text);
+
+	auto	   p   = &text.addr[blk.begin];
+	auto const end = &text.addr[blk.end];
+
+	out.resize(0);
+	while (p < end) {
+		auto line = p;
+
+		// lines not starting with an ID, such as comments or a CSV header, are no edges
+		p = skipSeparators(p, end);
+		if (p < end && (*p == '-' || *p == '+')) {
+			malformed(text, line);
+		}
+		if (p < end && isDigit(*p)) {
+			std::array<uint64_t, 2> e;
+			p	   = parseNumber(p, end, e[0]);
+			auto q = skipSeparators(p, end);
+			if (q == p || q == end || !isDigit(*q)) {
+				malformed(text, line);
+			}
+			p = parseNumber(q, end, e[1]);
+			if (p < end && !isSeparator(*p) && *p != '\r' && *p != '\n') {
+				malformed(text, line);
+			}
+			if (e[0] < base || e[1] < base) {
+				malformed(text, line);
+			}
+
+			out.push_back({e[0] - base, e[1] - base});
+			if (mirror && e[0] != e[1]) {
+				out.push_back({e[1] - base, e[0] - base});
+			}
+		}
+
+		// the rest of the line: comments, weights, '\r'
+		if (p < end && *p == '\n') {
+			p++;
+		} else {
+			auto nl = (uint8_t const *)memchr(p, '\n', end - p);
+			p		= (nl != nullptr) ? nl + 1 : end;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef D9F5FF2A_7E4C_40D1_918D_5BA1655AC698
+#define D9F5FF2A_7E4C_40D1_918D_5BA1655AC698
+
+#include "type.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#define __MANIFEST "manifest.log" // completed work of the pipeline, read back by --resume
+#define __PARTEXT  ".part"		  // output written under this suffix until it is complete
+
+// Completed work of the pipeline, an append-only log in the output folder.
+// A line "<stage> <item>" is made durable before the item's inputs are removed, so a resumed run
+// redoes only the items that were in flight. An empty item stands for the whole stage.
+class Manifest
+{
+private:
+	int								folderFd, logFd;
+	std::mutex						lock;
+	std::unordered_set<std::string> entries;
+
+public:
+	// reads the log back when resuming, starts an empty one otherwise
+	void init(fs::path const & folder, bool const resume);
+	~Manifest() noexcept;
+
+	// thread-safe; an item's files must be synced already, a whole stage flushes the file system
+	bool					 done(std::string const & stage, std::string const & item = "");
+	void					 finish(std::string const & stage, std::string const & item = "");
+	std::vector<std::string> items(std::string const & stage);
+};
+
+// crash safety: fileCommit() syncs a finished file and renames it to its final name
+void fileSync(fs::path const & path);
+void fileCommit(fs::path const & from, fs::path const & to);
+
+#endif /* D9F5FF2A_7E4C_40D1_918D_5BA1655AC698 */
@@ -0,0 +1,42 @@
+#ifndef C1F0A3D2_6E4B_4B8F_9A57_3D2E8C61B0A4
+#define C1F0A3D2_6E4B_4B8F_9A57_3D2E8C61B0A4
+
+#include "type.h"
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define __GORDERWIN	 5		   // placed vertices an overlap score is taken against
+#define __GORDERHUB	 256	   // neighbors of higher degree are not expanded for sibling scores
+#define __GORDERPART (1L << 20) // vertices per independent greedy partition, at most
+
+using Degree = std::vector<std::atomic<uint32_t>>;
+
+// Symmetric adjacency of the input without self loops, held for orderings that look past degrees.
+// Neighbors of v are col[ptr[v], ptr[v + 1]); duplicates in the input stay duplicated.
+struct Adjacency {
+	std::vector<uint64_t> ptr;
+	std::vector<uint32_t> col;
+};
+
+// relabel table (old ID -> new ID); the adjacency is null unless the ordering asked for it
+using OrderFunc = std::function<sp<std::vector<uint64_t>>(Degree const &, Adjacency const *)>;
+
+// Stage0 vertex ordering, chosen by relabelType on the command line.
+// Every ordering puts zero-degree vertices last, so the IDs in use stay dense.
+struct Ordering {
+	uint64_t	 relabelType;
+	char const * name;
+	char const * description;
+	bool		 adjacency; // needs the whole graph in memory, not only the degrees
+	OrderFunc	 func;
+};
+
+std::vector<Ordering> const & orderings();
+
+// by relabelType number or by name; nullptr if there is no such ordering
+Ordering const * orderingFind(std::string const & key);
+
+#endif /* C1F0A3D2_6E4B_4B8F_9A57_3D2E8C61B0A4 */
@@ -1,106 +1,184 @@
+#include "input.h"
+#include "order.h"
+#include "relabel.h"
 #include "type.h"
 #include "util.h"
 
-#include <tbb/blocked_range.h>
-#include <tbb/concurrent_vector.h>
-#include <tbb/parallel_sort.h>
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <vector>
 
-sp<std::vector<uint64_t>> stage0(fs::path const & inFolder,
-								 fs::path const & outFolder,
-								 uint64_t const	  maxVID,
-								 uint64_t const	  relabelType)
+#define __DEGCOMBINE 4096 // combining slots per counting thread, a power of two
+
+// Thread-local write combining in front of the shared degree counters.
+// Additions commute, so the counts are exact whatever the interleaving, and a hub costs one
+// relaxed atomic add per eviction from its slot instead of one per edge.
+struct DegreeCombiner {
+	Degree &			  degree;
+	std::vector<uint64_t> vid;
+	std::vector<uint32_t> cnt;
+
+	DegreeCombiner(Degree & degree)
+		: degree(degree), vid(__DEGCOMBINE, UINT64_MAX), cnt(__DEGCOMBINE, 0)
+	{
+	}
+
+	~DegreeCombiner()
+	{
+		for (size_t i = 0; i < __DEGCOMBINE; i++) {
+			this->evict(i);
+		}
+	}
+
+	void evict(size_t const i)
+	{
+		if (this->cnt[i] > 0) {
+			this->degree[this->vid[i]].fetch_add(this->cnt[i], std::memory_order_relaxed);
+			this->cnt[i] = 0;
+		}
+	}
+
+	void add(uint64_t const v, uint32_t const c)
+	{
+		auto i = v & (__DEGCOMBINE - 1);
+		if (this->vid[i] != v) {
+			this->evict(i);
+			this->vid[i] = v;
+		}
+		this->cnt[i] += c;
+	}
+};
+
+// Symmetric adjacency from a second read of the input, sized by the exact degrees.
+// Neighbor slots are claimed with relaxed atomics, so the order inside a list is arbitrary; none
+// of the orderings depend on it.
+static sp<Adjacency>
+loadAdjacency(fs::path const & inFolder, fs::path const & outFolder, Degree const & degree)
+{
+	if (degree.size() > UINT32_MAX) {
+		fprintf(stderr, "orderings on the adjacency take at most %u vertices\n", UINT32_MAX);
+		exit(EXIT_FAILURE);
+	}
+
+	auto adj = makeSp<Adjacency>();
+	adj->ptr.resize(degree.size() + 1);
+	adj->ptr[0] = 0;
+	for (size_t v = 0; v < degree.size(); v++) {
+		adj->ptr[v + 1] = adj->ptr[v] + degree[v].load(std::memory_order_relaxed);
+	}
+	adj->col.resize(adj->ptr.back());
+
+	std::vector<std::atomic<uint64_t>> fill(degree.size());
+	auto							   workers = std::thread::hardware_concurrency();
+	parallelDo(workers, [&](size_t const idx) {
+		for (auto i = idx; i < fill.size(); i += workers) {
+			fill[i].store(adj->ptr[i], std::memory_order_relaxed);
+		}
+	});
+
+	auto fListChan = fileMapList(fileList(inFolder, ""));
+	parallelDo(8, [&](size_t const i) {
+		for (auto & input : *fListChan) {
+			auto rowChan = splitInput(input, outFolder);
+
+			parallelDo(64, [&](size_t const j) {
+				InputBuffer buf;
+				for (auto & blk : *rowChan) {
+					auto row = [&](uint64_t const s, uint64_t const * dst, size_t const cnt) {
+						for (auto d = dst; d < dst + cnt; d++) {
+							if (s != *d) {
+								adj->col[fill[s].fetch_add(1, std::memory_order_relaxed)] = *d;
+								adj->col[fill[*d].fetch_add(1, std::memory_order_relaxed)] = s;
+							}
+						}
+					};
+					forEachInputRow(*input, blk, buf, row);
+				}
+			});
+		}
+	});
+
+	return adj;
+}
+
+sp<RelabelTable> stage0(fs::path const & inFolder,
+						fs::path const & outFolder,
+						uint64_t const	 maxVID,
+						uint64_t const	 relabelType)
 {
-	tbb::concurrent_vector<Reorder> temp(maxVID + 1);
+	auto ordering = orderingFind(std::to_string(relabelType));
+	if (ordering == nullptr) {
+		fprintf(stderr, "unknown relabelType: %ld\n", relabelType);
+		exit(EXIT_FAILURE);
+	}
+
+	Degree degree(maxVID + 1);
 
 	auto workers = std::thread::hardware_concurrency();
 	parallelDo(workers, [&](size_t const idx) {
-		for (auto i = idx; i < temp.size(); i += workers) {
-			temp[i].key = uint64_t(i);
-			temp[i].val = 0;
+		for (auto i = idx; i < degree.size(); i += workers) {
+			degree[i].store(0, std::memory_order_relaxed);
 		}
 	});
 
 	stopwatch("Stage0, Count degree", [&] {
-		auto fListChan = fileList(inFolder, "");
+		auto fListChan = fileMapList(fileList(inFolder, ""));
 		parallelDo(8, [&](size_t const i) {
-			for (auto & fPath : *fListChan) {
-				auto adj6		 = fileLoad<uint8_t>(fPath);
-				auto sRawDatChan = splitAdj6(adj6);
+			for (auto & input : *fListChan) {
+				auto rowChan = splitInput(input, outFolder);
 
 				parallelDo(64, [&](size_t const j) {
-					for (auto & dat : *sRawDatChan) {
-						auto s = dat.src;
-						temp[s].val += dat.cnt;
-
-						for (auto i = uint64_t(0); i < dat.cnt; i++) {
-							auto d = be6_le8(&(adj6->at(dat.dstStart + i * 6)));
+					DegreeCombiner comb(degree);
+					InputBuffer	   buf;
+					for (auto & blk : *rowChan) {
+						auto row = [&](uint64_t const s, uint64_t const * dst, size_t const cnt) {
+							// self loops count for neither endpoint
+							uint64_t loops = 0;
+							for (size_t i = 0; i < cnt; i++) {
+								auto d = dst[i];
 
-							if (s != d) {
-								temp[d].val++;
-							} else {
-								temp[s].val--;
+								if (s != d) {
+									comb.add(d, 1);
+								} else {
+									loops++;
+								}
 							}
-						}
+
+							comb.add(s, cnt - loops);
+						};
+						forEachInputRow(*input, blk, buf, row);
 					}
 				});
 			}
 		});
 	});
 
-	stopwatch("Stage0, Reorder vertices by rank", [&] {
-		switch (relabelType) {
-		case 1:
-			tbb::parallel_sort(temp.begin(), temp.end(), [](Reorder const & l, Reorder const & r) {
-				if (l.val == 0 && r.val != 0) {
-					return false;
-				} else if (l.val != 0 && r.val == 0) {
-					return true;
-				} else if (l.val == 0 && r.val == 0) {
-					return false;
-				} else {
-					if (l.val == r.val) {
-						return l.key < r.key;
-					} else {
-						return l.val < r.val;
-					}
-				}
-			});
-			break;
-		case 2:
-			tbb::parallel_sort(temp.begin(), temp.end(), [](Reorder const & l, Reorder const & r) {
-				if (l.val == r.val) {
-					return l.key > r.key;
-				} else {
-					return l.val > r.val;
-				}
-			});
-			break;
-		default:
-			exit(EXIT_FAILURE);
-		}
-
-		auto workers = std::thread::hardware_concurrency();
-
-		parallelDo(workers, [&](size_t const idx) {
-			for (auto i = idx; i < temp.size(); i += workers) {
-				temp[i].val = uint64_t(i);
-			}
-		});
-
-		tbb::parallel_sort(temp.begin(), temp.end(), [](Reorder const & l, Reorder const & r) {
-			return l.key < r.key;
-		});
-	});
+	sp<Adjacency> adj;
+	if (ordering->adjacency) {
+		stopwatch("Stage0, Load adjacency",
+				  [&] { adj = loadAdjacency(inFolder, outFolder, degree); });
+	}
 
-	auto out = makeSp<std::vector<uint64_t>>(temp.size());
+	sp<std::vector<uint64_t>> table;
+	stopwatch("Stage0, Order vertices, " + std::string(ordering->name),
+			  [&] { table = ordering->func(degree, adj.get()); });
+	adj.reset();
 
-	for (size_t i = 0; i < temp.size(); i++) {
-		out->at(i) = temp[i].val;
+	// kept with the table for sizing the grids, also when it is reused
+	RelabelHeader header;
+	header.relabelType = relabelType;
+	header.active	   = 0;
+	header.edges	   = 0;
+	for (auto & d : degree) {
+		auto c = d.load(std::memory_order_relaxed);
+		header.active += (c > 0);
+		header.edges += c;
 	}
+	header.edges /= 2;
 
-	// for (auto & o : *out) { printf("%ld ", o); } printf("\n");
+	// persisted with its inverse, then used through the mapped file like a reused one
+	stopwatch("Stage0, Save relabel table", [&] { relabelSave(outFolder, *table, header); });
 
-	return out;
-}
\ No newline at end of file
+	return relabelLoad(outFolder / __RELABELFWD);
+}
@@ -1,318 +1,109 @@
+#include "spill.h"
 #include "stage.h"
 #include "type.h"
 #include "util.h"
 
-#include <atomic>
-#include <chrono>
-#include <fstream>
-#include <iostream>
-#include <tbb/blocked_range.h>
-#include <tbb/parallel_for.h>
-#include <tbb/parallel_reduce.h>
-#include <tbb/parallel_scan.h>
-#include <tbb/parallel_sort.h>
+#include <GridCSR/Codec.h>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <string>
 #include <thread>
+#include <vector>
 
-static auto dedup(sp<std::vector<E32>> in)
-{
-	// init
-	auto out = makeSp<std::vector<E32>>(in->size());
-
-	std::vector<std::atomic<uint32_t>> bitvec(size_t(ceil(double(in->size()) / 32.0)));
-
-	auto getBit = [&bitvec](size_t const i) {
-		return (bitvec[i / 32].load() & (1 << (i % 32))) != 0;
-	};
-	auto setBit = [&bitvec](size_t const i) { bitvec[i / 32].fetch_or(1 << (i % 32)); };
-
-	std::vector<uint64_t> pSumRes(in->size() + 1);
-
-	// printf("input size: %ld, bitvec size: %ld, pSumRes size: %ld\n", in->size(), bitvec.size(),
-	// pSumRes.size());
-	// prepare bit array
-	tbb::parallel_for(
-		tbb::blocked_range<size_t>(0, bitvec.size()),
-		[&](tbb::blocked_range<size_t> const & r) {
-			for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-				for (size_t offset = 0; offset < r.grainsize(); offset++) {
-					auto i = grain + offset;
-
-					bitvec[i] = 0;
-				}
-			}
-		},
-		tbb::auto_partitioner());
-
-	// printf("insz: %ld, bitarray prepared\n", in->size());
-
-	// prepare exclusive sum array
-	tbb::parallel_for(
-		tbb::blocked_range<size_t>(0, pSumRes.size()),
-		[&](tbb::blocked_range<size_t> const & r) {
-			for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-				for (size_t offset = 0; offset < r.grainsize(); offset++) {
-					auto i = grain + offset;
-
-					pSumRes[i] = 0;
-				}
-			}
-		},
-		tbb::auto_partitioner());
-
-	// printf("insz: %ld, pSumRes prepared\n", in->size());
-
-	// sort
-	tbb::parallel_sort(in->begin(), in->end(), [&](E32 const & l, E32 const & r) {
-		return (l[0] < r[0]) || ((l[0] == r[0]) && (l[1] < r[1]));
-	});
-
-	// printf("insz: %ld, sorted\n", in->size());
-	// set bit 1 which is left != right (not the case: left == right)
-	std::atomic<uint64_t> ones;
-	ones.store(0);
-	tbb::parallel_for(
-		tbb::blocked_range<size_t>(0, in->size() - 1),
-		[&](tbb::blocked_range<size_t> const & r) {
-			uint64_t myOnes = 0;
-			for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-				for (size_t offset = 0; offset < r.grainsize(); offset++) {
-					auto curr = grain + offset;
-					auto next = grain + offset + 1;
-					if ((in->at(curr)[0] != in->at(next)[0]) ||
-						(in->at(curr)[1] != in->at(next)[1])) {
-						setBit(curr);
-						myOnes++;
-					}
-				}
-			}
-			ones.fetch_add(myOnes);
-		},
-		tbb::auto_partitioner());
-	setBit(in->size() - 1);
-	ones.fetch_add(1);
-
-	// printf("insz:%ld, bit setted\n", in->size());
-
-	// exclusive sum
-	tbb::parallel_scan(
-		tbb::blocked_range<size_t>(0, in->size()),
-		0L, // very important! not be just '0'
-		[&](tbb::blocked_range<size_t> const & r, uint64_t sum, bool isFinalScan) {
-			auto temp = sum;
-			for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-				for (size_t offset = 0; offset < r.grainsize(); offset++) {
-					auto i = grain + offset;
-					temp += (getBit(i) ? 1 : 0);
-					if (isFinalScan) {
-						pSumRes[i + 1] = temp;
-					}
-				}
-			}
-			return temp;
-		},
-		[&](size_t const & l, size_t const & r) { return l + r; },
-		tbb::auto_partitioner());
-
-	// printf("insz:%ld, ones: %ld\n", in->size(), ones.load());
-
-	out->resize(ones);
-
-	// printf("insz:%ld, resized\n", in->size());
-
-	// reduce out vector
-	tbb::parallel_for(
-		tbb::blocked_range<size_t>(0, in->size()),
-		[&](tbb::blocked_range<size_t> const & r) {
-			for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-				for (size_t offset = 0; offset < r.grainsize(); offset++) {
-					auto i = grain + offset;
-
-					if (getBit(i)) {
-						// try {
-						out->at(pSumRes[i]) = in->at(i);
-						//} catch (std::out_of_range & e) {
-						//	fprintf(stderr, "%s %ld\n", e.what(), i);
-						// exit(EXIT_FAILURE);
-						//}
-					}
-				}
-			}
-		},
-		tbb::auto_partitioner());
-
-	// printf("insz:%ld, outvector writed\n", in->size());
-
-	return out;
-}
+#define __CSRBUF (1L << 20) // V32 entries buffered per output file
 
-static void writeCSR(fs::path const outTarget, sp<std::vector<E32>> in)
+// merges the sorted runs of one grid and streams the deduplicated edges out as CSR
+static void writeCSR(fs::path const				   outTarget,
+					 FileView const &			   el32,
+					 std::vector<uint64_t> const & runs,
+					 bool const					   compress)
 {
+	std::array<std::string, 3>		ext = {".row", ".ptr", ".col"};
+	std::array<int, 3>				fp;
+	std::array<std::vector<V32>, 3> buf;
+
+	for (size_t i = 0; i < fp.size(); i++) {
+		auto partTarget = fs::path(outTarget.string() + ext[i] + __PARTEXT);
+		fp[i]			= open64(partTarget.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+		assert_errno(fp[i] >= 0);
+		buf[i].reserve(__CSRBUF);
+	}
 
-	auto fillRowAndPtr = std::thread([&, in] {
-		// fill
-		std::vector<std::atomic<uint32_t>> bitvec(size_t(ceil(double(in->size()) / 32.0)));
-
-		auto getBit = [&bitvec](size_t const i) {
-			return (bitvec[i / 32].load() & (1 << (i % 32))) != 0;
-		};
-		auto setBit = [&bitvec](size_t const i) { bitvec[i / 32].fetch_or(1 << (i % 32)); };
-
-		std::vector<uint64_t> pSumRes(in->size() + 1);
-
-		// prepare bit array
-		tbb::parallel_for(
-			tbb::blocked_range<size_t>(0, bitvec.size()),
-			[&](tbb::blocked_range<size_t> const & r) {
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto i = grain + offset;
-
-						bitvec[i] = 0;
-					}
-				}
-			},
-			tbb::auto_partitioner());
-
-		// prepare exclusive sum array
-		tbb::parallel_for(
-			tbb::blocked_range<size_t>(0, pSumRes.size()),
-			[&](tbb::blocked_range<size_t> const & r) {
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto i = grain + offset;
-
-						pSumRes[i] = 0;
-					}
-				}
-			},
-			tbb::auto_partitioner());
-
-		// set bit 1 which is left != right (not the case: left == right)
-		std::atomic<uint64_t> ones;
-		ones.store(0);
-		tbb::parallel_for(
-			tbb::blocked_range<size_t>(1, in->size()),
-			[&](tbb::blocked_range<size_t> const & r) {
-				uint64_t myOnes = 0;
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto prev = grain + offset - 1;
-						auto curr = grain + offset;
-						if (in->at(prev)[0] != in->at(curr)[0]) {
-							setBit(curr);
-							myOnes++;
-						}
-					}
-				}
-				ones.fetch_add(myOnes);
-			},
-			tbb::auto_partitioner());
-		setBit(0);
-		ones.fetch_add(1);
-
-		// exclusive sum
-		tbb::parallel_scan(
-			tbb::blocked_range<size_t>(0, in->size()),
-			0L, // very important! not be just '0'
-			[&](tbb::blocked_range<size_t> const & r, uint64_t sum, bool isFinalScan) {
-				auto temp = sum;
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto i = grain + offset;
-						temp += (getBit(i) ? 1 : 0);
-						if (isFinalScan) {
-							pSumRes[i + 1] = temp;
-						}
-					}
-				}
-				return temp;
-			},
-			[&](size_t const & l, size_t const & r) { return l + r; },
-			tbb::auto_partitioner());
-
-		////////////////
-		auto saveRow = std::thread([&] {
-			std::vector<V32> out(ones);
-
-			tbb::parallel_for(
-				tbb::blocked_range<size_t>(0, in->size()),
-				[&](tbb::blocked_range<size_t> const & r) {
-					for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-						for (size_t offset = 0; offset < r.grainsize(); offset++) {
-							auto i = grain + offset;
-
-							if (getBit(i)) {
-								out[pSumRes[i]] = in->at(i)[0];
-							}
-						}
-					}
-				},
-				tbb::auto_partitioner());
-			auto trueTarget = fs::path(outTarget.string() + ".row");
-			fileSave(trueTarget, out.data(), out.size() * sizeof(V32));
-		});
-
-		auto savePtr = std::thread([&] {
-			std::vector<V32> out(ones + 1);
-
-			tbb::parallel_for(
-				tbb::blocked_range<size_t>(0, in->size()),
-				[&](tbb::blocked_range<size_t> const & r) {
-					for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-						for (size_t offset = 0; offset < r.grainsize(); offset++) {
-							auto i = grain + offset;
-
-							if (getBit(i)) {
-								out[pSumRes[i]] = i;
-							}
-						}
-					}
-				},
-				tbb::auto_partitioner());
-			out.back()		= in->size();
-			auto trueTarget = fs::path(outTarget.string() + ".ptr");
-			fileSave(trueTarget, out.data(), out.size() * sizeof(V32));
-		});
+	// the encoded .col replaces the plain one; a full buffer is a whole number of its blocks, and
+	// the header is written again once the count is known
+	GridCSR::ColEncoder	 encoder;
+	std::vector<uint8_t> code;
+	if (compress) {
+		code.resize(GridCSR::colBound(__CSRBUF));
+		auto header = encoder.header();
+		fileWrite(fp[2], &header, sizeof(header));
+	}
 
-		if (saveRow.joinable()) {
-			saveRow.join();
+	// .ptr entries are 32 bit unless the grid may hold 2^32 edges or more, as told by the summed
+	// run lengths before deduplication
+	auto const			  runEdges = std::accumulate(runs.begin(), runs.end(), uint64_t(0));
+	auto const			  ptrWide  = (runEdges > std::numeric_limits<V32>::max());
+	std::vector<uint64_t> ptr64;
+
+	auto flush = [&](size_t const i) {
+		if (i == 1 && ptrWide) {
+			fileWrite(fp[i], ptr64.data(), ptr64.size() * sizeof(uint64_t));
+			ptr64.resize(0);
+		} else if (i == 2 && compress) {
+			fileWrite(fp[i], code.data(), encoder.put(buf[i].data(), buf[i].size(), code.data()));
+		} else {
+			fileWrite(fp[i], buf[i].data(), buf[i].size() * sizeof(V32));
 		}
+		buf[i].resize(0);
+	};
 
-		if (savePtr.joinable()) {
-			savePtr.join();
+	auto push = [&](size_t const i, V32 const v) {
+		buf[i].push_back(v);
+		if (buf[i].size() == __CSRBUF) {
+			flush(i);
 		}
-	});
-
-	auto fillCol = std::thread([&, in] {
-		// fill col
-		std::vector<V32> out(in->size());
+	};
 
-		tbb::parallel_for(
-			tbb::blocked_range<size_t>(0, in->size()),
-			[&](tbb::blocked_range<size_t> const & r) {
-				for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-					for (size_t offset = 0; offset < r.grainsize(); offset++) {
-						auto i = grain + offset;
+	auto pushPtr = [&](uint64_t const v) {
+		if (!ptrWide) {
+			push(1, V32(v));
+			return;
+		}
+		ptr64.push_back(v);
+		if (ptr64.size() == __CSRBUF) {
+			flush(1);
+		}
+	};
 
-						out[i] = in->at(i)[1];
-					}
-				}
-			},
-			tbb::auto_partitioner());
-		auto trueTarget = fs::path(outTarget.string() + ".col");
-		fileSave(trueTarget, out.data(), out.size() * sizeof(V32));
+	uint64_t edges = 0;
+	V32		 row   = 0;
+	forEachMergedEdge(el32, runs, [&](E32 const & e) {
+		if (edges == 0 || e[0] != row) {
+			row = e[0];
+			push(0, e[0]);
+			pushPtr(edges);
+		}
+		push(2, e[1]);
+		edges++;
 	});
+	pushPtr(edges);
 
-	if (fillCol.joinable()) {
-		fillCol.join();
-	}
-
-	if (fillRowAndPtr.joinable()) {
-		fillRowAndPtr.join();
+	for (size_t i = 0; i < fp.size(); i++) {
+		flush(i);
+		if (i == 2 && compress) {
+			auto header = encoder.header();
+			assert_errno(pwrite64(fp[i], &header, sizeof(header), 0) == sizeof(header));
+		}
+		close(fp[i]);
+		fileCommit(outTarget.string() + ext[i] + __PARTEXT, outTarget.string() + ext[i]);
 	}
 }
 
-void stage2(fs::path const & inFolder, fs::path const & outFolder)
+void stage2(fs::path const & inFolder,
+			fs::path const & outFolder,
+			bool const		 compress,
+			Manifest &		 manifest)
 {
 	auto jobs = [&] {
 		auto out = makeSp<bchan<fs::path>>(16);
@@ -329,13 +120,17 @@ void stage2(fs::path const & inFolder, fs::path const & outFolder)
 	parallelDo(8, [&](size_t const i) {
 		for (auto & fPath : *jobs) {
 			stopwatch("Stage2, " + std::string(fPath), [&] {
-				auto rawData = fileLoad<E32>(fPath);
-				auto deduped = dedup(rawData);
-				auto target	 = fPath.parent_path() / fPath.stem();
-				// auto sortedTarget = fs::path(fPath.string() + ".sort");
-				// fileSave(sortedTarget, deduped->data(), deduped->size() * sizeof(E32));
-				writeCSR(target, deduped);
+				auto runPath = fs::path(fPath.string() + __SPILLRUN);
+				auto stem	 = fPath.stem().string();
+
+				// a grid finished just before a crash only has its inputs left to remove
+				if (!manifest.done("Stage2", stem)) {
+					auto target = fPath.parent_path() / fPath.stem();
+					writeCSR(target, *fileMap(fPath), *fileLoad<uint64_t>(runPath), compress);
+					manifest.finish("Stage2", stem);
+				}
 				fs::remove(fPath);
+				fs::remove(runPath);
 			});
 		}
 	});
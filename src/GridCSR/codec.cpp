@@ -0,0 +1,148 @@
+#include <GridCSR/Codec.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+
+// pick the simdpp backend from the target flags; without SSSE3 the decoder stays scalar
+#if defined(__AVX2__)
+#define SIMDPP_ARCH_X86_AVX2
+#elif defined(__SSSE3__)
+#define SIMDPP_ARCH_X86_SSSE3
+#endif
+#include <simdpp/simd.h>
+
+static uint64_t const COL_MAGIC = 0x31306c6f43524347; // "GCRCol01"
+static size_t const COL_BLOCK = 128;
+
+// bytes of a value's encoding, 1 to 4
+static size_t valueByte(uint32_t const v) {
+    return (v < (1U << 8)) ? 1 : (v < (1U << 16)) ? 2 : (v < (1U << 24)) ? 3 : 4;
+}
+
+size_t GridCSR::colBound(size_t const count) {
+    return sizeof(ColHeader) + (count + 3) / 4 + count * sizeof(Vertex);
+}
+
+size_t GridCSR::ColEncoder::put(Vertex const * in, size_t const count, uint8_t * out) {
+    auto p = out;
+    for (size_t b = 0; b < count; b += COL_BLOCK) {
+        auto n = std::min(COL_BLOCK, count - b);
+        auto ctrl = p;
+        auto data = p + (n + 3) / 4;
+        memset(ctrl, 0, (n + 3) / 4);
+
+        for (size_t i = 0; i < n; i++) {
+            uint32_t d = in[b + i] - this->prev;
+            this->prev = in[b + i];
+
+            auto len = valueByte(d);
+            ctrl[i / 4] |= uint8_t((len - 1) << (2 * (i % 4)));
+            for (size_t k = 0; k < len; k++) {
+                *data++ = uint8_t(d >> (8 * k));
+            }
+        }
+        p = data;
+    }
+    this->count += count;
+    return p - out;
+}
+
+GridCSR::ColHeader GridCSR::ColEncoder::header() const {
+    ColHeader h;
+    h.magic = COL_MAGIC;
+    h.count = this->count;
+    return h;
+}
+
+size_t GridCSR::colCount(void const * in, size_t const byte) {
+    ColHeader h;
+    if (byte < sizeof(h)) {
+        throw std::runtime_error("not an encoded .col file");
+    }
+    memcpy(&h, in, sizeof(h));
+    if (h.magic != COL_MAGIC) {
+        throw std::runtime_error("not an encoded .col file");
+    }
+    return h.count;
+}
+
+#if SIMDPP_USE_SSSE3
+// per control byte: where each byte of the four values comes from in the next 16 data bytes (0x80
+// for a zero byte), and how many data bytes the four values take
+struct DecodeTable {
+    uint8_t shuffle[256][16];
+    uint8_t length[256];
+
+    DecodeTable() {
+        for (size_t c = 0; c < 256; c++) {
+            uint8_t src = 0;
+            for (size_t j = 0; j < 4; j++) {
+                auto len = ((c >> (2 * j)) & 3) + 1;
+                for (size_t k = 0; k < 4; k++) {
+                    this->shuffle[c][4 * j + k] = (k < len) ? src++ : 0x80;
+                }
+            }
+            this->length[c] = src;
+        }
+    }
+};
+
+static DecodeTable const decodeTable;
+#endif
+
+void GridCSR::colDecode(void const * in, size_t const byte, Vertex * out) {
+    auto const count = colCount(in, byte);
+    auto p = (uint8_t const *)in + sizeof(ColHeader);
+    auto const end = (uint8_t const *)in + byte;
+
+    Vertex prev = 0;
+    for (size_t b = 0; b < count; b += COL_BLOCK) {
+        auto n = std::min(COL_BLOCK, count - b);
+        auto ctrl = p;
+        auto data = p + (n + 3) / 4;
+        size_t i = 0;
+
+#if SIMDPP_USE_SSSE3
+        using Byte16 = simdpp::uint8<16>;
+        using Vertex4 = simdpp::uint32<4>;
+
+        // four values per control byte: spread their bytes to 32 bit lanes, then a prefix sum
+        // over the lanes on top of the last ID so far; a load never reads past the file
+        Vertex4 carry = simdpp::splat<Vertex4>(prev);
+        for (; i + 4 <= n && data + 16 <= end; i += 4) {
+            auto c = ctrl[i / 4];
+            Byte16 raw = simdpp::load_u(data);
+            Byte16 mask = simdpp::load_u(decodeTable.shuffle[c]);
+            Vertex4 v = simdpp::bit_cast<Vertex4>(simdpp::permute_zbytes16(raw, mask));
+
+            v = simdpp::add(v, simdpp::move4_r<1>(v));
+            v = simdpp::add(v, simdpp::move4_r<2>(v));
+            v = simdpp::add(v, carry);
+            simdpp::store_u(&out[b + i], v);
+
+            carry = simdpp::permute4<3, 3, 3, 3>(v);
+            data += decodeTable.length[c];
+        }
+        prev = simdpp::extract<0>(carry);
+#endif
+
+        // the tail of the block, or all of it without SIMD
+        for (; i < n; i++) {
+            auto len = size_t((ctrl[i / 4] >> (2 * (i % 4))) & 3) + 1;
+            if (data + len > end) {
+                throw std::runtime_error("truncated .col file");
+            }
+
+            uint32_t d = 0;
+            for (size_t k = 0; k < len; k++) {
+                d |= uint32_t(data[k]) << (8 * k);
+            }
+            data += len;
+
+            prev += d;
+            out[b + i] = prev;
+        }
+        p = data;
+    }
+}
@@ -0,0 +1,240 @@
+#include <GridCSR/Codec.h>
+#include <GridCSR/Reader.h>
+
+#include <algorithm>
+#include <string.h>
+
+// one part of a merged grid: its rows and .ptr entries of either width, and its .col once a row
+// turns out to be in more than one part
+struct MergeSource {
+    GridCSR::FileView rowFile, ptrFile, colFile;
+    GridCSR::Vertex const * row = nullptr;
+    GridCSR::Vertex const * col = nullptr;
+    size_t rows = 0, pos = 0;
+    bool wide = false;
+
+    uint64_t ptr(size_t const r) const {
+        return (this->wide) ? ((uint64_t const *)this->ptrFile.addr)[r]
+                            : ((uint32_t const *)this->ptrFile.addr)[r];
+    }
+};
+
+// Goes through the union of the parts' rows in order and writes to the outputs that are not null.
+// With row alone it skips the edges, with none of them it only counts. load(i) maps the .col of
+// part i.
+template <typename Load, typename Stat>
+static void mergeRun(std::vector<MergeSource> & in,
+                     Load load,
+                     GridCSR::Vertex * row,
+                     void * ptr,
+                     bool const ptrWide,
+                     GridCSR::Vertex * col,
+                     Stat & stat) {
+    auto const edges = (ptr != nullptr || col != nullptr || row == nullptr);
+    auto putPtr = [&](size_t const r, uint64_t const v) {
+        if (ptrWide) {
+            ((uint64_t *)ptr)[r] = v;
+        } else {
+            ((uint32_t *)ptr)[r] = uint32_t(v);
+        }
+    };
+
+    std::vector<size_t> sel, cur(in.size()), end(in.size());
+    while (true) {
+        // the next row ID and the parts that have it
+        sel.clear();
+        GridCSR::Vertex v = 0;
+        for (size_t i = 0; i < in.size(); i++) {
+            auto & s = in[i];
+            if (s.pos == s.rows || (!sel.empty() && s.row[s.pos] > v)) {
+                continue;
+            }
+            if (sel.empty() || s.row[s.pos] < v) {
+                sel.clear();
+                v = s.row[s.pos];
+            }
+            sel.push_back(i);
+        }
+        if (sel.empty()) {
+            break;
+        }
+
+        if (row != nullptr) {
+            row[stat.rows] = v;
+        }
+
+        if (edges) {
+            if (ptr != nullptr) {
+                putPtr(stat.rows, stat.edges);
+            }
+
+            size_t n = 0;
+            if (sel.size() == 1 && col == nullptr) {
+                auto & s = in[sel[0]];
+                n = s.ptr(s.pos + 1) - s.ptr(s.pos);
+            } else {
+                // k-way union of the sorted rows, each ID once
+                for (auto i : sel) {
+                    load(i);
+                    cur[i] = in[i].ptr(in[i].pos);
+                    end[i] = in[i].ptr(in[i].pos + 1);
+                }
+                while (true) {
+                    auto found = false;
+                    GridCSR::Vertex m = 0;
+                    for (auto i : sel) {
+                        if (cur[i] < end[i] && (!found || in[i].col[cur[i]] < m)) {
+                            m = in[i].col[cur[i]];
+                            found = true;
+                        }
+                    }
+                    if (!found) {
+                        break;
+                    }
+                    for (auto i : sel) {
+                        while (cur[i] < end[i] && in[i].col[cur[i]] == m) {
+                            cur[i]++;
+                        }
+                    }
+                    if (col != nullptr) {
+                        col[stat.edges + n] = m;
+                    }
+                    n++;
+                }
+            }
+            stat.edges += n;
+            stat.maxRow = std::max(stat.maxRow, n);
+        }
+
+        stat.rows++;
+        for (auto i : sel) {
+            in[i].pos++;
+        }
+    }
+
+    if (ptr != nullptr) {
+        putPtr(stat.rows, stat.edges);
+    }
+}
+
+void GridCSR::Reader::openDeltas() {
+    auto & each = this->meta.grid.each;
+    auto const own = each.size();
+
+    for (auto const & name : this->meta.delta) {
+        auto d = std::make_shared<Reader>();
+        d->open(this->folder / name);
+
+        if (!d->meta.delta.empty()) {
+            throw std::runtime_error("delta " + name + " has deltas of its own");
+        }
+        if (d->meta.info.width.row != this->meta.info.width.row) {
+            throw std::runtime_error("delta " + name + " is cut into grids of another width");
+        }
+
+        // a grid only a delta has is listed after the dataset's own
+        for (size_t g = 0; g < d->grids(); g++) {
+            auto const & dg = d->meta.grid.each[g];
+            auto it = this->index.find(dg.name);
+            size_t at;
+            if (it == this->index.end()) {
+                at = each.size();
+                each.push_back(dg);
+                this->index[dg.name] = at;
+                this->parts.emplace_back();
+                this->stored.emplace_back();
+                this->bytes.emplace_back();
+            } else {
+                at = it->second;
+            }
+
+            if (this->parts[at].empty() && at < own) {
+                this->parts[at].push_back({this, at});
+            }
+            this->parts[at].push_back({d.get(), g});
+        }
+
+        auto & info = this->meta.info;
+        info.count.row = std::max(info.count.row, d->meta.info.count.row);
+        info.count.col = std::max(info.count.col, d->meta.info.count.col);
+        info.max_vid = std::max(info.max_vid, d->meta.info.max_vid);
+        this->meta.grid.detail = this->meta.grid.detail && d->meta.grid.detail;
+
+        this->deltas.push_back(d);
+    }
+
+    // a merged grid is a plain one in memory; sizing it reads the rows of its parts, and the .col
+    // of a part only when it shares a row with another part
+    for (size_t g = 0; g < each.size(); g++) {
+        if (!this->merged(g)) {
+            continue;
+        }
+
+        MergeStat stat;
+        this->merge(g, nullptr, nullptr, nullptr, &stat);
+
+        auto bits = (stat.edges >> 32 > 0) ? 64 : 32;
+        this->bytes[g] = {stat.rows * sizeof(Vertex), (stat.rows + 1) * bits / 8,
+                          stat.edges * sizeof(Vertex),
+                          (this->files() == 4) ? rowIndexByte(this->meta.info.width.row, stat.rows)
+                                               : 0};
+
+        if (this->meta.grid.detail) {
+            auto & m = each[g];
+            m.byte.row = this->bytes[g][0];
+            m.byte.ptr = this->bytes[g][1];
+            m.byte.col = this->bytes[g][2];
+            m.byte.idx = this->bytes[g][3];
+            m.count.row = stat.rows;
+            m.count.edge = stat.edges;
+            m.max_row = stat.maxRow;
+            m.ptr_bits = bits;
+        }
+    }
+}
+
+GridCSR::FileView GridCSR::Reader::partFile(Part const & p, size_t const type) const {
+    if (p.reader != this) {
+        return p.reader->file(p.grid, type);
+    }
+    if (!this->encoded(type)) {
+        return this->map(p.grid, type);
+    }
+
+    // the grid's own .col, decoded; bytes already holds the size of the merged one
+    auto src = this->map(p.grid, type);
+    auto f = this->buffer(colCount(src.addr, src.byte) * sizeof(Vertex));
+    if (f.byte > 0) {
+        colDecode(src.addr, src.byte, (Vertex *)f.addr);
+    }
+    return f;
+}
+
+void GridCSR::Reader::merge(size_t const grid,
+                            Vertex * row,
+                            void * ptr,
+                            Vertex * col,
+                            MergeStat * stat) const {
+    auto const & parts = this->parts[grid];
+
+    std::vector<MergeSource> in(parts.size());
+    for (size_t i = 0; i < parts.size(); i++) {
+        auto & s = in[i];
+        s.rowFile = this->partFile(parts[i], 0);
+        s.ptrFile = this->partFile(parts[i], 1);
+        s.row = (Vertex const *)s.rowFile.addr;
+        s.rows = s.rowFile.byte / sizeof(Vertex);
+        s.wide = (s.ptrFile.byte == (s.rows + 1) * sizeof(uint64_t));
+    }
+
+    auto load = [&](size_t const i) {
+        if (in[i].col == nullptr) {
+            in[i].colFile = this->partFile(parts[i], 2);
+            in[i].col = (Vertex const *)in[i].colFile.addr;
+        }
+    };
+
+    MergeStat local;
+    auto wide = (this->ptrBits(grid) == 64);
+    mergeRun(in, load, row, ptr, wide, col, (stat != nullptr) ? *stat : local);
+}
@@ -46,9 +46,27 @@ void GridCSR::MetaData::Save(GridCSR::FS::path const & filePath) {
     JSON j;
 
     SAVE(j, dataname);
+    if (!this->pack.empty()) {
+        SAVE(j, pack);
+    }
+    if (!this->codec.empty()) {
+        SAVE(j, codec);
+    }
+    if (!this->delta.empty()) {
+        SAVE(j, delta);
+    }
+    if (!this->transpose.empty()) {
+        SAVE(j, transpose);
+    }
+    if (!this->orientation.empty()) {
+        SAVE(j, orientation);
+    }
     SAVE(j, extension, row);
     SAVE(j, extension, ptr);
     SAVE(j, extension, col);
+    if (!this->extension.idx.empty()) {
+        SAVE(j, extension, idx);
+    }
     SAVE(j, info, count, row);
     SAVE(j, info, count, col);
     SAVE(j, info, width, row);
@@ -60,6 +78,25 @@ void GridCSR::MetaData::Save(GridCSR::FS::path const & filePath) {
         j["grid"][i]["name"] = g.name;
         j["grid"][i]["index"]["row"] = g.index.row;
         j["grid"][i]["index"]["col"] = g.index.col;
+
+        if (this->grid.detail) {
+            auto & d = j["grid"][i];
+            d["depth"] = g.depth;
+            d["shard"]["row"] = g.shard.row;
+            d["shard"]["col"] = g.shard.col;
+            d["range"]["row"] = {g.range.row.begin, g.range.row.end};
+            d["range"]["col"] = {g.range.col.begin, g.range.col.end};
+            d["byte"]["row"] = g.byte.row;
+            d["byte"]["ptr"] = g.byte.ptr;
+            d["byte"]["col"] = g.byte.col;
+            if (!this->extension.idx.empty()) {
+                d["byte"]["idx"] = g.byte.idx;
+            }
+            d["count"]["edge"] = g.count.edge;
+            d["count"]["row"] = g.count.row;
+            d["max_row"] = g.max_row;
+            d["ptr_bits"] = g.ptr_bits;
+        }
     }
 
     std::ofstream f;
@@ -75,9 +112,20 @@ void GridCSR::MetaData::Load(GridCSR::FS::path const & filePath) {
     f.close();
 
     LOAD(j, dataname);
+    this->pack = (j.count("pack") > 0) ? j["pack"].get<std::string>() : std::string();
+    this->codec = (j.count("codec") > 0) ? j["codec"].get<std::string>() : std::string();
+    this->delta = (j.count("delta") > 0) ? j["delta"].get<std::vector<std::string>>()
+                                          : std::vector<std::string>();
+    this->transpose =
+        (j.count("transpose") > 0) ? j["transpose"].get<std::string>() : std::string();
+    this->orientation =
+        (j.count("orientation") > 0) ? j["orientation"].get<std::string>() : std::string();
     LOAD(j, extension, row);
     LOAD(j, extension, ptr);
     LOAD(j, extension, col);
+    this->extension.idx = (j["extension"].count("idx") > 0)
+                              ? j["extension"]["idx"].get<std::string>()
+                              : std::string();
     LOAD(j, info, count, row);
     LOAD(j, info, count, col);
     LOAD(j, info, width, row);
@@ -86,10 +134,35 @@ void GridCSR::MetaData::Load(GridCSR::FS::path const & filePath) {
 
     this->grid.each.resize(j["grid"].size());
 
+    // written with statistics only when every grid has them
+    this->grid.detail = !this->grid.each.empty();
+    for (auto const & d : j["grid"]) {
+        this->grid.detail = this->grid.detail && d.count("byte") > 0;
+    }
+
     for (size_t i = 0; i < j["grid"].size(); i++) {
         auto & g = this->grid.each[i];
         g.name = j["grid"][i]["name"];
         g.index.row = j["grid"][i]["index"]["row"].get<decltype(g.index.row)>();
         g.index.col = j["grid"][i]["index"]["col"].get<decltype(g.index.col)>();
+
+        if (this->grid.detail) {
+            auto const & d = j["grid"][i];
+            g.depth = d["depth"].get<size_t>();
+            g.shard.row = d["shard"]["row"].get<size_t>();
+            g.shard.col = d["shard"]["col"].get<size_t>();
+            g.range.row.begin = d["range"]["row"][0].get<size_t>();
+            g.range.row.end = d["range"]["row"][1].get<size_t>();
+            g.range.col.begin = d["range"]["col"][0].get<size_t>();
+            g.range.col.end = d["range"]["col"][1].get<size_t>();
+            g.byte.row = d["byte"]["row"].get<size_t>();
+            g.byte.ptr = d["byte"]["ptr"].get<size_t>();
+            g.byte.col = d["byte"]["col"].get<size_t>();
+            g.byte.idx = (d["byte"].count("idx") > 0) ? d["byte"]["idx"].get<size_t>() : 0;
+            g.count.edge = d["count"]["edge"].get<size_t>();
+            g.count.row = d["count"]["row"].get<size_t>();
+            g.max_row = d["max_row"].get<size_t>();
+            g.ptr_bits = (d.count("ptr_bits") > 0) ? d["ptr_bits"].get<size_t>() : 32;
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include <GridCSR/Pack.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static uint64_t const PACK_MAGIC   = 0x316b636150524347; // "GCRPack1"
+static uint64_t const PACK_VERSION = 1;
+
+static void packFail(std::string const & what, GridCSR::FS::path const & path) {
+    throw std::runtime_error(what + " " + path.string() + ": " + strerror(errno));
+}
+
+static uint64_t alignUp(uint64_t const x, uint64_t const align) {
+    return (x + align - 1) & ~(align - 1);
+}
+
+// pwrite() until all of it is written
+static bool writeAll(int const fd, void const * data, size_t const byte, uint64_t const offset) {
+    auto p = (uint8_t const *)data;
+    for (size_t done = 0; done < byte;) {
+        auto b = pwrite64(fd, p + done, byte - done, offset + done);
+        if (b <= 0) {
+            return false;
+        }
+        done += b;
+    }
+    return true;
+}
+
+void GridCSR::PackWriter::init(FS::path const & path, size_t const align, size_t const files) {
+    if (align < sizeof(PackHeader) || (align & (align - 1)) != 0) {
+        throw std::invalid_argument("pack alignment must be a power of two and hold the header");
+    }
+
+    this->fd = open64(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (this->fd < 0) {
+        packFail("cannot create", path);
+    }
+
+    this->align = align;
+    this->files = files;
+    this->end = align; // the header owns the first segment slot
+}
+
+GridCSR::PackWriter::~PackWriter() noexcept {
+    if (this->fd >= 0) {
+        ::close(this->fd);
+    }
+}
+
+void GridCSR::PackWriter::put(std::string const & name,
+                              void const * const * data,
+                              size_t const * byte) {
+    Entry e;
+    e.name = name;
+    e.segment.resize(this->files);
+
+    // segments are reserved in one go, so a grid's files sit next to each other
+    {
+        std::lock_guard<std::mutex> lg(this->lock);
+        for (size_t i = 0; i < this->files; i++) {
+            e.segment[i].offset = alignUp(this->end, this->align);
+            e.segment[i].byte = byte[i];
+            this->end = e.segment[i].offset + byte[i];
+        }
+        this->entries.push_back(e);
+    }
+
+    for (size_t i = 0; i < this->files; i++) {
+        if (!writeAll(this->fd, data[i], byte[i], e.segment[i].offset)) {
+            throw std::runtime_error("cannot write pack segment of " + name + ": " +
+                                     strerror(errno));
+        }
+    }
+}
+
+void GridCSR::PackWriter::close() {
+    std::vector<uint64_t> table;
+    std::string names;
+    for (auto & e : this->entries) {
+        table.push_back(names.size());
+        table.push_back(e.name.size());
+        for (auto & s : e.segment) {
+            table.push_back(s.offset);
+            table.push_back(s.byte);
+        }
+        names += e.name;
+    }
+
+    PackHeader h;
+    h.magic = PACK_MAGIC;
+    h.version = PACK_VERSION;
+    h.align = this->align;
+    h.files = this->files;
+    h.grids = this->entries.size();
+    h.tableOffset = alignUp(this->end, sizeof(uint64_t));
+    h.tableByte = table.size() * sizeof(uint64_t) + names.size();
+
+    auto namesOffset = h.tableOffset + table.size() * sizeof(uint64_t);
+    if (!writeAll(this->fd, table.data(), table.size() * sizeof(uint64_t), h.tableOffset) ||
+        !writeAll(this->fd, names.data(), names.size(), namesOffset) ||
+        !writeAll(this->fd, &h, sizeof(h), 0)) {
+        throw std::runtime_error(std::string("cannot write pack table: ") + strerror(errno));
+    }
+
+    ::close(this->fd);
+    this->fd = -1;
+}
+
+void GridCSR::Pack::open(FS::path const & path) {
+    this->path = path;
+
+    this->fd = open64(path.c_str(), O_RDONLY);
+    if (this->fd < 0) {
+        packFail("cannot open", path);
+    }
+
+    this->byte = FS::file_size(path);
+    if (this->byte < sizeof(PackHeader)) {
+        throw std::runtime_error("not a pack: " + path.string());
+    }
+
+    auto a = mmap64(nullptr, this->byte, PROT_READ, MAP_SHARED, this->fd, 0);
+    if (a == MAP_FAILED) {
+        packFail("cannot map", path);
+    }
+    this->addr = (uint8_t const *)a;
+
+    // segments aligned to 2MB can be backed by transparent huge pages
+    if (((PackHeader const *)this->addr)->align >= (1UL << 21)) {
+        madvise(a, this->byte, MADV_HUGEPAGE);
+    }
+
+    this->header = *(PackHeader const *)this->addr;
+    auto & h = this->header;
+    if (h.magic != PACK_MAGIC || h.version != PACK_VERSION ||
+        h.tableOffset + h.tableByte > this->byte) {
+        throw std::runtime_error("not a pack or a damaged one: " + path.string());
+    }
+
+    auto record = 2 + 2 * h.files;
+    auto table = (uint64_t const *)&this->addr[h.tableOffset];
+    auto names = (char const *)&table[h.grids * record];
+
+    this->names.resize(h.grids);
+    this->segments.resize(h.grids * h.files);
+    this->index.reserve(h.grids);
+    for (size_t g = 0; g < h.grids; g++) {
+        auto r = &table[g * record];
+        this->names[g] = std::string(&names[r[0]], r[1]);
+        for (size_t i = 0; i < h.files; i++) {
+            this->segments[g * h.files + i] = PackSegment{r[2 + 2 * i], r[3 + 2 * i]};
+        }
+        this->index[this->names[g]] = g;
+    }
+}
+
+GridCSR::Pack::~Pack() noexcept {
+    if (this->addr != nullptr) {
+        munmap((void *)this->addr, this->byte);
+    }
+    if (this->fd >= 0) {
+        ::close(this->fd);
+    }
+}
+
+GridCSR::PackSegment const & GridCSR::Pack::segment(std::string const & name,
+                                                    size_t const file) const {
+    return this->segments[this->index.at(name) * this->header.files + file];
+}
+
+void const * GridCSR::Pack::data(std::string const & name, size_t const file) const {
+    return &this->addr[this->segment(name, file).offset];
+}
+
+void GridCSR::Pack::read(std::string const & name, size_t const file, void * dst) const {
+    auto & s = this->segment(name, file);
+    auto p = (uint8_t *)dst;
+    for (size_t done = 0; done < s.byte;) {
+        auto b = pread64(this->fd, p + done, s.byte - done, s.offset + done);
+        if (b <= 0) {
+            packFail("cannot read", this->path);
+        }
+        done += b;
+    }
+}
@@ -0,0 +1,232 @@
+#include <GridCSR/Codec.h>
+#include <GridCSR/Reader.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static void readerFail(std::string const & what, GridCSR::FS::path const & path) {
+    throw std::runtime_error(what + " " + path.string() + ": " + strerror(errno));
+}
+
+// buffers of a reader that maps its files, which only decoded .col files need
+class MallocProvider : public GridCSR::BufferProvider {
+public:
+    void * alloc(size_t const byte) override {
+        auto addr = malloc(byte);
+        if (addr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return addr;
+    }
+
+    void free(void * addr, size_t const) noexcept override { ::free(addr); }
+};
+
+void GridCSR::Reader::open(FS::path const & folder, std::shared_ptr<BufferProvider> provider) {
+    this->folder = folder;
+    this->mapped = (provider == nullptr);
+    this->provider = (this->mapped) ? std::make_shared<MallocProvider>() : provider;
+
+    this->hasMeta = FS::exists(folder / "meta.json");
+    if (this->hasMeta) {
+        this->meta.Load(folder / "meta.json");
+    } else {
+        this->meta.extension.row = ".row";
+        this->meta.extension.ptr = ".ptr";
+        this->meta.extension.col = ".col";
+
+        std::vector<std::string> names;
+        for (FS::directory_iterator curr(folder), end; curr != end; ++curr) {
+            auto const & p = curr->path();
+            if (FS::is_regular_file(p) && p.extension() == this->meta.extension.row &&
+                FS::file_size(p) > 0) {
+                names.push_back(p.stem().string());
+            }
+        }
+        std::sort(names.begin(), names.end());
+
+        this->meta.grid.each.resize(names.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            this->meta.grid.each[i].name = names[i];
+        }
+    }
+
+    if (!this->meta.codec.empty() && this->meta.codec != COLCODEC) {
+        throw std::runtime_error("unknown .col codec " + this->meta.codec + " in " +
+                                 folder.string());
+    }
+
+    this->extension = {this->meta.extension.row, this->meta.extension.ptr,
+                       this->meta.extension.col, this->meta.extension.idx};
+
+    if (!this->meta.pack.empty()) {
+        this->pack = std::make_shared<Pack>();
+        this->pack->open(folder / this->meta.pack);
+    }
+
+    // sizes come from the metadata when it lists them, so opening touches no grid file
+    auto const & each = this->meta.grid.each;
+    this->stored.resize(each.size());
+    this->bytes.resize(each.size());
+    this->index.reserve(each.size());
+    for (size_t g = 0; g < each.size(); g++) {
+        if (this->meta.grid.detail) {
+            this->stored[g] = {each[g].byte.row, each[g].byte.ptr, each[g].byte.col,
+                               each[g].byte.idx};
+        } else {
+            for (size_t t = 0; t < this->files(); t++) {
+                this->stored[g][t] = (this->pack != nullptr)
+                                         ? this->pack->segment(each[g].name, t).byte
+                                         : FS::file_size(this->filePath(g, t));
+            }
+        }
+
+        this->bytes[g] = this->stored[g];
+        if (this->encoded(2)) {
+            this->bytes[g][2] = (this->meta.grid.detail)
+                                    ? each[g].count.edge * sizeof(Vertex)
+                                    : colCount(this->map(g, 2).addr, this->stored[g][2]) *
+                                          sizeof(Vertex);
+        }
+
+        this->index[each[g].name] = g;
+    }
+
+    this->parts.assign(each.size(), {});
+    if (!this->meta.delta.empty()) {
+        this->openDeltas();
+    }
+}
+
+GridCSR::FS::path GridCSR::Reader::filePath(size_t const grid, size_t const type) const {
+    return this->folder / (this->meta.grid.each[grid].name + this->extension[type]);
+}
+
+bool GridCSR::Reader::encoded(size_t const type) const {
+    return type == 2 && !this->meta.codec.empty();
+}
+
+GridCSR::FileView GridCSR::Reader::map(size_t const grid, size_t const type) const {
+    FileView f;
+    f.byte = this->stored[grid][type];
+    if (f.byte == 0) {
+        return f;
+    }
+
+    // a segment of the pack lives as long as the pack does
+    if (this->pack != nullptr) {
+        f.addr = this->pack->data(this->meta.grid.each[grid].name, type);
+        f.hold = std::shared_ptr<void const>(this->pack, f.addr);
+        return f;
+    }
+
+    auto path = this->filePath(grid, type);
+    auto fd = open64(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        readerFail("cannot open", path);
+    }
+    auto addr = mmap64(nullptr, f.byte, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        readerFail("cannot map", path);
+    }
+
+    // a grid is read through as a whole, so the kernel may read ahead all of it
+    madvise(addr, f.byte, MADV_WILLNEED);
+
+    auto byte = f.byte;
+    f.addr = addr;
+    f.hold = std::shared_ptr<void const>(addr, [byte](void const * p) { munmap((void *)p, byte); });
+    return f;
+}
+
+GridCSR::FileView GridCSR::Reader::buffer(size_t const byte) const {
+    FileView f;
+    f.byte = byte;
+    if (f.byte == 0) {
+        return f;
+    }
+
+    auto provider = this->provider;
+    auto buffer = provider->alloc(byte);
+    f.hold = std::shared_ptr<void const>(
+        buffer, [provider, byte](void const * p) { provider->free((void *)p, byte); });
+    f.addr = buffer;
+    return f;
+}
+
+GridCSR::FileView GridCSR::Reader::file(size_t const grid, size_t const type) const {
+    if (this->mapped && !this->encoded(type) && !this->merged(grid)) {
+        return this->map(grid, type);
+    }
+
+    auto f = this->buffer(this->bytes[grid][type]);
+    if (f.byte > 0) {
+        this->read(grid, type, (void *)f.addr);
+    }
+    return f;
+}
+
+GridCSR::GridView GridCSR::Reader::view(size_t const grid) const {
+    GridView v;
+    for (size_t t = 0; t < this->files(); t++) {
+        v.file[t] = this->file(grid, t);
+    }
+    return v;
+}
+
+void GridCSR::Reader::read(size_t const grid, size_t const type, void * dst) const {
+    if (!this->merged(grid)) {
+        this->readStored(grid, type, dst);
+        return;
+    }
+
+    // the index is built from the merged rows, which take no .col
+    if (type == 3) {
+        std::vector<Vertex> row(this->byte(grid, 0) / sizeof(Vertex));
+        this->merge(grid, row.data(), nullptr, nullptr);
+        rowIndexBuild(row.data(), row.size(), this->meta.info.width.row, dst);
+        return;
+    }
+
+    this->merge(grid, (type == 0) ? (Vertex *)dst : nullptr, (type == 1) ? dst : nullptr,
+                (type == 2) ? (Vertex *)dst : nullptr);
+}
+
+void GridCSR::Reader::readStored(size_t const grid, size_t const type, void * dst) const {
+    // decoded straight from the mapping, no staging copy of the encoded bytes
+    if (this->encoded(type)) {
+        auto src = this->map(grid, type);
+        colDecode(src.addr, src.byte, (Vertex *)dst);
+        return;
+    }
+
+    if (this->pack != nullptr) {
+        this->pack->read(this->meta.grid.each[grid].name, type, dst);
+        return;
+    }
+
+    auto path = this->filePath(grid, type);
+    auto fd = open64(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        readerFail("cannot open", path);
+    }
+
+    auto p = (uint8_t *)dst;
+    auto byte = this->stored[grid][type];
+    for (size_t done = 0; done < byte;) {
+        auto b = pread64(fd, p + done, byte - done, done);
+        if (b <= 0) {
+            ::close(fd);
+            readerFail("cannot read", path);
+        }
+        done += b;
+    }
+    ::close(fd);
+}
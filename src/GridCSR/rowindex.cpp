@@ -0,0 +1,69 @@
+#include <GridCSR/RowIndex.h>
+
+#include <stdexcept>
+#include <string.h>
+
+static uint64_t const IDX_MAGIC = 0x3130786449524347; // "GCRIdx01"
+
+static uint64_t indexShift(size_t const width, size_t const rows) {
+    uint64_t shift = 0;
+    while ((width >> shift) > std::max(rows, size_t(1))) {
+        shift++;
+    }
+    return shift;
+}
+
+static size_t indexBlocks(size_t const width, uint64_t const shift) {
+    return (width + (1UL << shift) - 1) >> shift;
+}
+
+size_t GridCSR::rowIndexByte(size_t const width, size_t const rows) {
+    auto blocks = indexBlocks(width, indexShift(width, rows));
+    return sizeof(RowIndexHeader) + (blocks + 1) * sizeof(uint32_t);
+}
+
+void GridCSR::rowIndexBuild(Vertex const * row, size_t const rows, size_t const width, void * out) {
+    RowIndexHeader h;
+    h.magic = IDX_MAGIC;
+    h.width = width;
+    h.rows = rows;
+    h.shift = indexShift(width, rows);
+    memcpy(out, &h, sizeof(h));
+
+    // one pass over the sorted rows; a block takes the count of the rows before it
+    auto dir = (uint32_t *)((uint8_t *)out + sizeof(h));
+    auto blocks = indexBlocks(width, h.shift);
+    size_t r = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        while (r < rows && (row[r] >> h.shift) < b) {
+            r++;
+        }
+        dir[b] = uint32_t(r);
+    }
+    dir[blocks] = uint32_t(rows);
+}
+
+GridCSR::RowIndex::RowIndex(void const * idx,
+                            size_t const byte,
+                            Vertex const * row,
+                            size_t const rows) {
+    RowIndexHeader h;
+    if (byte < sizeof(h)) {
+        throw std::runtime_error("not a row index file");
+    }
+    memcpy(&h, idx, sizeof(h));
+    if (h.magic != IDX_MAGIC || h.shift >= 64 ||
+        byte != sizeof(h) + (indexBlocks(h.width, h.shift) + 1) * sizeof(uint32_t)) {
+        throw std::runtime_error("not a row index file");
+    }
+    if (h.rows != rows) {
+        throw std::runtime_error("the row index is of another grid: " + std::to_string(h.rows) +
+                                 " rows instead of " + std::to_string(rows));
+    }
+
+    this->row = row;
+    this->dir = (uint32_t const *)((uint8_t const *)idx + sizeof(h));
+    this->width = h.width;
+    this->rows = h.rows;
+    this->shift = h.shift;
+}
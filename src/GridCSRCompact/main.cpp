@@ -0,0 +1,222 @@
+#include <GridCSR/Codec.h>
+#include <GridCSR/GridCSR.h>
+#include <GridCSR/Pack.h>
+#include <GridCSR/Reader.h>
+
+#include <algorithm>
+#include <array>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = GridCSR::FS;
+using MetaGrid = decltype(GridCSR::MetaData::grid)::GridInfo;
+
+#define __METAFILE	  "meta.json"	 // GridCSR::MetaData of the dataset
+#define __COMPACTFILE "compact.json" // metadata of a compaction that is committed, not yet applied
+#define __DELTADIR	  "delta"		 // folder of the deltas of a dataset, see Adj6ToGCSR --append
+#define __PARTEXT	  ".part"		 // output written under this suffix until it is committed
+
+static void fail(char const * what, fs::path const & path)
+{
+	fprintf(stderr, "%s %s: %s\n", what, path.c_str(), strerror(errno));
+	exit(EXIT_FAILURE);
+}
+
+static void pathSync(fs::path const & path)
+{
+	auto fd = open64(path.c_str(), O_RDONLY);
+	if (fd < 0 || fsync(fd) != 0) {
+		fail("cannot sync", path);
+	}
+	close(fd);
+}
+
+// writes a whole file and syncs it
+static void fileSave(fs::path const & path, void const * data, size_t const byte)
+{
+	auto fd = open64(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+	if (fd < 0) {
+		fail("cannot create", path);
+	}
+
+	auto p = (uint8_t const *)data;
+	for (size_t done = 0; done < byte;) {
+		auto b = write(fd, p + done, byte - done);
+		if (b <= 0) {
+			fail("cannot write", path);
+		}
+		done += b;
+	}
+
+	if (fsync(fd) != 0) {
+		fail("cannot sync", path);
+	}
+	close(fd);
+}
+
+// a merged grid's files as they are stored: the .col encoded when the dataset's are
+struct GridOut {
+	GridCSR::GridView		    view;
+	std::vector<uint8_t>	    encoded;
+	std::array<void const *, 4> data;
+	std::array<size_t, 4>	    byte;
+};
+
+static void gridOut(GridCSR::Reader const & reader, size_t const g, GridOut & out)
+{
+	out.view = reader.view(g);
+	for (size_t t = 0; t < reader.files(); t++) {
+		out.data[t] = out.view.file[t].addr;
+		out.byte[t] = out.view.file[t].byte;
+	}
+
+	if (!reader.meta.codec.empty()) {
+		auto col = out.view.col();
+
+		GridCSR::ColEncoder enc;
+		out.encoded.resize(GridCSR::colBound(col.count));
+		auto byte = enc.put(col.addr, col.count, &out.encoded[sizeof(GridCSR::ColHeader)]);
+		auto h	  = enc.header();
+		memcpy(out.encoded.data(), &h, sizeof(h));
+
+		out.data[2] = out.encoded.data();
+		out.byte[2] = sizeof(h) + byte;
+	}
+}
+
+// Writes the merged grids under __PARTEXT, a new container for a packed dataset, then commits the
+// compaction by renaming its metadata to __COMPACTFILE.
+static void compact(fs::path const & folder, GridCSR::Reader const & reader)
+{
+	auto meta = reader.meta;
+	meta.delta.clear();
+
+	std::vector<std::string> ext = {meta.extension.row, meta.extension.ptr, meta.extension.col};
+	if (!meta.extension.idx.empty()) {
+		ext.push_back(meta.extension.idx);
+	}
+
+	size_t merged = 0;
+	if (meta.pack.empty()) {
+		for (size_t g = 0; g < reader.grids(); g++) {
+			if (!reader.merged(g)) {
+				continue;
+			}
+
+			GridOut out;
+			gridOut(reader, g, out);
+			for (size_t t = 0; t < ext.size(); t++) {
+				auto path = folder / (meta.grid.each[g].name + ext[t] + __PARTEXT);
+				fileSave(path, out.data[t], out.byte[t]);
+			}
+			meta.grid.each[g].byte.col = out.byte[2];
+			merged++;
+		}
+	} else {
+		// the grids no delta has are copied over as they are stored
+		GridCSR::Pack old;
+		old.open(folder / meta.pack);
+
+		auto partPath = folder / (meta.pack + __PARTEXT);
+
+		GridCSR::PackWriter writer;
+		writer.init(partPath, old.align(), ext.size());
+		for (size_t g = 0; g < reader.grids(); g++) {
+			auto const & name = meta.grid.each[g].name;
+
+			GridOut out;
+			if (reader.merged(g)) {
+				gridOut(reader, g, out);
+				meta.grid.each[g].byte.col = out.byte[2];
+				merged++;
+			} else {
+				for (size_t t = 0; t < ext.size(); t++) {
+					out.data[t] = old.data(name, t);
+					out.byte[t] = old.segment(name, t).byte;
+				}
+			}
+			writer.put(name, out.data.data(), out.byte.data());
+		}
+		writer.close();
+		pathSync(partPath);
+	}
+
+	std::sort(meta.grid.each.begin(),
+			  meta.grid.each.end(),
+			  [](MetaGrid const & l, MetaGrid const & r) {
+				  return std::tie(l.index.row, l.index.col, l.name) <
+						 std::tie(r.index.row, r.index.col, r.name);
+			  });
+
+	auto partPath = folder / (std::string(__COMPACTFILE) + __PARTEXT);
+	meta.Save(partPath);
+	pathSync(partPath);
+	fs::rename(partPath, folder / __COMPACTFILE);
+	pathSync(folder);
+
+	printf("%zu grids merged from %zu deltas\n", merged, reader.meta.delta.size());
+}
+
+// Moves a committed compaction in place; run again after a crash, it finishes the same way.
+static void apply(fs::path const & folder)
+{
+	for (fs::directory_iterator iter(folder), end; iter != end; iter++) {
+		auto const & path = iter->path();
+		if (fs::is_regular_file(path) && path.extension() == __PARTEXT) {
+			fs::rename(path, fs::path(path).replace_extension());
+		}
+	}
+	pathSync(folder);
+
+	fs::rename(folder / __COMPACTFILE, folder / __METAFILE);
+	pathSync(folder);
+
+	fs::remove_all(folder / __DELTADIR);
+}
+
+int main(int argc, char * argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr,
+				"usage: %s <folder>\n"
+				"merges the deltas of a dataset, which Adj6ToGCSR --append wrote, into its grids;\n"
+				"readers may keep the dataset open, an --append to it must not run meanwhile\n",
+				argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	auto folder = fs::absolute(fs::path(argv[1]));
+
+	try {
+		if (!fs::exists(folder / __COMPACTFILE)) {
+			// leftovers of a compaction that never committed
+			for (fs::directory_iterator iter(folder), end; iter != end; iter++) {
+				if (fs::is_regular_file(iter->path()) && iter->path().extension() == __PARTEXT) {
+					fs::remove(iter->path());
+				}
+			}
+
+			GridCSR::Reader reader;
+			reader.open(folder);
+			if (reader.meta.delta.empty()) {
+				printf("no deltas in %s\n", folder.c_str());
+				return 0;
+			}
+			compact(folder, reader);
+		}
+
+		apply(folder);
+	} catch (std::exception const & e) {
+		fprintf(stderr, "%s\n", e.what());
+		exit(EXIT_FAILURE);
+	}
+
+	return 0;
+}
@@ -3,34 +3,17 @@
 
 #include <BuddySystem/BuddySystem.h>
 #include <cuda_runtime.h>
-#include <fcntl.h>
 #include <fstream>
 #include <limits>
 #include <mutex>
 #include <string>
 #include <tuple>
-#include <unistd.h>
 #include <unordered_map>
 
-static auto genPath(Context & ctx, Key const & k)
+// position of the key's grid in the reader
+static size_t genGrid(Context & ctx, Key const & k)
 {
-	auto baseString =
-		std::string(ctx.folderPath) + std::to_string(k.idx[0]) + "-" + std::to_string(k.idx[1]);
-
-	fs::path finalPath;
-	switch (k.type) {
-	case DataType::Row:
-		finalPath = fs::path(baseString + ".row");
-		break;
-	case DataType::Ptr:
-		finalPath = fs::path(baseString + ".ptr");
-		break;
-	case DataType::Col:
-		finalPath = fs::path(baseString + ".col");
-		break;
-	}
-
-	return finalPath;
+	return ctx.reader.find(std::to_string(k.idx[0]) + "-" + std::to_string(k.idx[1]));
 }
 
 static auto methodDone(Context & ctx, DeviceID myID)
@@ -163,7 +146,7 @@ static auto methodReady(Context & ctx, DeviceID myID)
 			} else {
 				// printf("[%2d] %s Miss!\n", myID, tx.key.print().c_str());
 
-				myInfo.byte = fs::file_size(genPath(ctx, tx.key));
+				myInfo.byte = ctx.reader.byte(genGrid(ctx, tx.key), tx.key.type);
 
 				tryAllocate(ctx, tx.key, myID, myInfo, ul, iHaveLock);
 
@@ -184,23 +167,8 @@ static auto methodReady(Context & ctx, DeviceID myID)
 				if (myID == -1) {
 					// printf("start to read!\n");
 
-					// CPU
-					// std::ifstream f(otherInfo.path, std::ios::binary);
-					// printf("[%2d] %s fread       SSD[%s]->Host[%p], %ld bytes)\n", myID,
-					// tx.key.print().c_str(), otherInfo.path.c_str(), myInfo.ptr, otherInfo.byte);
-					auto fp = open64(otherInfo.path.c_str(), O_RDONLY);
-
-					constexpr uint64_t cDef		 = (1L << 30); // chunk Default
-					uint64_t		   chunkByte = (myInfo.byte < cDef) ? myInfo.byte : cDef;
-					uint64_t		   bytePos	 = 0;
-					while (bytePos < myInfo.byte) {
-						chunkByte =
-							(myInfo.byte - bytePos > chunkByte) ? chunkByte : myInfo.byte - bytePos;
-						auto loaded = read(fp, &(((uint8_t *)myInfo.ptr)[bytePos]), chunkByte);
-						bytePos += loaded;
-					}
-
-					close(fp);
+					// CPU: copied to the host buffer, an encoded .col decoded on the way
+					ctx.reader.read(genGrid(ctx, tx.key), tx.key.type, myInfo.ptr);
 				} else {
 					// GPU
 					// printf("[%2d] %s cudaMemcpy Host[%p]-> GPU[%p], %ld bytes)\n", myID,
@@ -256,8 +224,7 @@ void DataManager(Context & ctx, DeviceID myID)
 							0,
 						};
 						myInfo.ptr	= nullptr;
-						myInfo.path = genPath(ctx, tx.key);
-						myInfo.byte = fs::file_size(myInfo.path);
+						myInfo.byte = ctx.reader.byte(genGrid(ctx, tx.key), tx.key.type);
 						myInfo.ok	= true;
 						myInfo.hit	= true;
 
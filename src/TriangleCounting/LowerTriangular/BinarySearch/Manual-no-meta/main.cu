@@ -4,7 +4,7 @@
 #include "make.cuh"
 #include "type.cuh"
 
-#include <GridCSR/GridCSR.h>
+#include <GridCSR/Reader.h>
 #include <cub/device/device_scan.cuh>
 #include <cuda_runtime.h>
 #include <iostream>
@@ -162,8 +162,21 @@ static void init(Context & ctx, int argc, char * argv[])
 	}
 
 	ctx.folderPath = fs::path(fs::path(std::string(argv[1]) + "/").parent_path().string() + "/");
-	ctx.grid.count = findMaxGridIndex(ctx.folderPath, ".row") + 1;
-	ctx.grid.width = (1 << 24);
+	ctx.reader.open(ctx.folderPath);
+
+	// width and grid count recorded by the converter; folders without metadata keep the fixed
+	// width and are scanned for their grids
+	auto const & meta = ctx.reader.meta;
+	ctx.grid.width	  = (ctx.reader.hasMeta) ? meta.info.width.row : (1 << 24);
+	// the kernels take 32 bit .ptr entries only
+	for (size_t i = 0; i < ctx.reader.grids(); i++) {
+		if (ctx.reader.ptrBits(i) > 32) {
+			fprintf(stderr, "%s: 64 bit .ptr in grid %s\n", argv[0], meta.grid.each[i].name.c_str());
+			exit(EXIT_FAILURE);
+		}
+	}
+	ctx.grid.count = (meta.grid.detail) ? std::max(meta.info.count.row, meta.info.count.col)
+										: findMaxGridIndex(ctx.folderPath, ".row") + 1;
 
 	for (int i = 0; i < 3; i++) {
 		ctx.setting[i] = strtol(argv[i + 2], nullptr, 10);
@@ -3,13 +3,11 @@
 
 #include <BuddySystem/BuddySystem.h>
 #include <cuda_runtime.h>
-#include <fcntl.h>
 #include <fstream>
 #include <limits>
 #include <mutex>
 #include <string>
 #include <tuple>
-#include <unistd.h>
 #include <unordered_map>
 
 static auto genPath(Context & ctx, Key const & k)
@@ -163,10 +161,7 @@ static auto methodReady(Context & ctx, DeviceID myID)
 			} else {
 				// printf("[%2d] %s Miss!\n", myID, tx.key.print().c_str());
 
-				auto exts		= std::array<std::string, 3>{".row", ".ptr", ".col"};
-				auto targetPath = fs::path((ctx.folderPath / fs::path(tx.key.idx)).string() +
-										   exts[(size_t)tx.key.type]);
-				myInfo.byte		= fs::file_size(targetPath);
+				myInfo.byte = ctx.reader.byte(ctx.reader.find(tx.key.idx), tx.key.type);
 
 				tryAllocate(ctx, tx.key, myID, myInfo, ul, iHaveLock);
 
@@ -174,25 +169,8 @@ static auto methodReady(Context & ctx, DeviceID myID)
 				if (myID == -1) {
 					// printf("start to read!\n");
 
-					// CPU
-					// std::ifstream f(otherInfo.path, std::ios::binary);
-					// printf("[%2d] %s fread       SSD[%s]->Host[%p], %ld bytes)\n", myID,
-					// tx.key.print().c_str(), otherInfo.path.c_str(), myInfo.ptr,
-					// otherInfo.byte);
-
-					auto fp = open64(targetPath.c_str(), O_RDONLY);
-
-					constexpr uint64_t cDef		 = (1L << 30); // chunk Default
-					uint64_t		   chunkByte = (myInfo.byte < cDef) ? myInfo.byte : cDef;
-					uint64_t		   bytePos	 = 0;
-					while (bytePos < myInfo.byte) {
-						chunkByte =
-							(myInfo.byte - bytePos > chunkByte) ? chunkByte : myInfo.byte - bytePos;
-						auto loaded = read(fp, &(((uint8_t *)myInfo.ptr)[bytePos]), chunkByte);
-						bytePos += loaded;
-					}
-
-					close(fp);
+					// CPU: copied to the host buffer, an encoded .col decoded on the way
+					ctx.reader.read(ctx.reader.find(tx.key.idx), tx.key.type, myInfo.ptr);
 				} else {
 					auto otherInfo = requestToReady(ctx, tx.key, myCtx.conn->upstream);
 					// GPU
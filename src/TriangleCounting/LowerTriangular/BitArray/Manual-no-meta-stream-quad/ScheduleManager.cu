@@ -2,6 +2,8 @@
 #include "make.cuh"
 #include "type.cuh"
 
+#include <GridCSR/GridCSR.h>
+#include <map>
 #include <memory>
 #include <regex>
 #include <thread>
@@ -117,29 +119,37 @@ static bool checkAvail(std::array<ShardIndex, 3> const & in)
 	return IS(A[y], B[y]) && IS(B[x], C[x]) && IS(A[x], C[y]);
 }
 
-// ls | awk -F . '{print $1}' | awk -F , '{print $1}' | uniq | wc -l 를 하면 됨
-static auto getGridSize(fs::path const & directory, fs::path const & extension)
+// Shards of every grid, found once. A converter that lists its grids in meta.json saves the
+// folder scan; older output is scanned a single time instead of once per grid triple.
+static auto shardList(fs::path const & folder)
 {
-	uint32_t   out = 0;
-	std::regex regex("^(\\d*)-(\\d*)(?:,(\\d*),(\\d*)-(\\d*))?$");
+	std::map<XY, std::vector<ShardIndex>> out;
 
-	for (fs::recursive_directory_iterator curr(directory), end; curr != end; ++curr) {
-		if (fs::is_regular_file(curr->path()) && fs::file_size(curr->path()) > 0) {
-			// printf("%s", curr->path().c_str());
+	GridCSR::MetaData meta;
+	if (fs::exists(folder / "meta.json")) {
+		meta.Load(folder / "meta.json");
+	}
+
+	if (meta.grid.detail) {
+		for (auto & g : meta.grid.each) {
 			ShardIndex sIdx;
-			if (sIdx.parse(curr->path().stem().string()) && curr->path().extension() == extension) {
-				// printf(" matched: (%d,%d),%d,(%d,%d)", sIdx.grid[0], sIdx.grid[1], sIdx.depth,
-				// sIdx.shard[0], sIdx.shard[1]);
+			if (sIdx.parse(g.name)) {
+				out[sIdx.grid].push_back(sIdx);
 			}
-			// printf("\n");
-
-			out = std::max(sIdx.grid[0], out);
-			out = std::max(sIdx.grid[1], out);
 		}
-		// printf("\n");
+		return out;
 	}
 
-	return out + 1;
+	for (fs::recursive_directory_iterator curr(folder), end; curr != end; ++curr) {
+		if (fs::is_regular_file(curr->path()) && fs::file_size(curr->path()) > 0 &&
+			curr->path().extension() == ".row") {
+			ShardIndex sIdx;
+			if (sIdx.parse(curr->path().stem().string())) {
+				out[sIdx.grid].push_back(sIdx);
+			}
+		}
+	}
+	return out;
 }
 
 std::shared_ptr<bchan<Command>> ScheduleManager(Context const & ctx)
@@ -147,7 +157,8 @@ std::shared_ptr<bchan<Command>> ScheduleManager(Context const & ctx)
 	auto out = makeSp<bchan<Command>>(16);
 
 	std::thread([=] {
-		auto const MAXROW = getGridSize(ctx.folderPath, ".row");
+		auto const MAXROW = ctx.grid.count;
+		auto const shards = shardList(ctx.folderPath);
 		// printf("MAXROW: %d\n", MAXROW);
 
 		for (uint32_t row = 0; row < MAXROW; row++) {
@@ -157,42 +168,16 @@ std::shared_ptr<bchan<Command>> ScheduleManager(Context const & ctx)
 					// printf("(%d,%d),(%d,%d),(%d,%d)\n", gidx[0][0], gidx[0][1], gidx[1][0],
 					// gidx[1][1], gidx[2][0], gidx[2][1]);
 
-					auto findShards = [&ctx](XY const & idx) {
-						std::vector<fs::path> out;
-
-						std::regex regex("^" + std::to_string(idx[0]) + "-" +
-										 std::to_string(idx[1]) + "(?:,\\d*,\\d*-\\d*)?$");
-
-						for (fs::recursive_directory_iterator curr(ctx.folderPath), end;
-							 curr != end;
-							 ++curr) {
-							// printf("FINDSHARD:%s\n", curr->path().c_str());
-							if (fs::is_regular_file(curr->path()) &&
-								fs::file_size(curr->path()) > 0 &&
-								curr->path().extension() == ".row") {
-								if (std::regex_search(curr->path().stem().string(), regex)) {
-									out.push_back(curr->path());
-								}
-							}
-						}
+					auto findShards = [&shards](XY const & idx) -> std::vector<ShardIndex> const & {
+						static std::vector<ShardIndex> const none;
 
-						return out;
+						auto iter = shards.find(idx);
+						return (iter != shards.end()) ? iter->second : none;
 					};
 
-					for (auto & APath : findShards(gidx[0])) {
-						ShardIndex A;
-						A.parse(APath.stem().string());
-						// printf("SHARD: %s\n", APath.c_str());
-						for (auto & BPath : findShards(gidx[1])) {
-							ShardIndex B;
-							B.parse(BPath.stem().string());
-							// printf("SHARD: %s, %s\n", APath.c_str(), BPath.c_str());
-							for (auto & CPath : findShards(gidx[2])) {
-								ShardIndex C;
-								C.parse(CPath.stem().string());
-								// printf("SHARD: %s, %s, %s\n", APath.c_str(), BPath.c_str(),
-								// CPath.c_str());
-
+					for (auto & A : findShards(gidx[0])) {
+						for (auto & B : findShards(gidx[1])) {
+							for (auto & C : findShards(gidx[2])) {
 								if (checkAvail(std::array<ShardIndex, 3>{A, B, C})) {
 									/*
 									printf("(%d,%d),%d,(%d,%d)",
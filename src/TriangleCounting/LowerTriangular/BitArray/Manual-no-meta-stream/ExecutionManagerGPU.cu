@@ -58,10 +58,15 @@ static __global__ void kernel(Grids const	 g,
 							  Lookup const * lookup2,
 							  uint32_t *	 bitarr0,
 							  uint32_t *	 bitarr1,
+							  uint32_t const gridWidth,
 							  Count *		 count)
 {
-	uint32_t * mybm0   = &bitarr0[(GRIDWIDTH >> EXP_BITMAP0) * blockIdx.x];
-	uint32_t * mybm1   = &bitarr1[(GRIDWIDTH >> EXP_BITMAP1) * blockIdx.x];
+	// per-block bitmaps, laid out as allocated from the grid width in the metadata
+	auto const stride0 = (gridWidth + (1 << EXP_BITMAP0) - 1) >> EXP_BITMAP0;
+	auto const stride1 = (gridWidth + (1 << EXP_BITMAP1) - 1) >> EXP_BITMAP1;
+
+	uint32_t * mybm0   = &bitarr0[stride0 * blockIdx.x];
+	uint32_t * mybm1   = &bitarr1[stride1 * blockIdx.x];
 	Count	   mycount = 0;
 
 	__shared__ int SHARED[1024];
@@ -198,6 +203,7 @@ Count launchKernelGPU(Context & ctx, DeviceID myID, size_t myStreamID, Grids & G
 										   myCtx.lookup.G2.ptr,
 										   myCtx.bitarr.lv0.ptr,
 										   myCtx.bitarr.lv1.ptr,
+										   ctx.grid.width,
 										   myCtx.count.ptr);
 	CUDACHECK();
 
@@ -10,6 +10,7 @@ namespace fs = std::filesystem;
 
 #include <BuddySystem/BuddySystem.h>
 #include <GridCSR/GridCSR.h>
+#include <GridCSR/Reader.h>
 #include <array>
 #include <atomic>
 #include <boost/fiber/all.hpp>
@@ -194,6 +195,7 @@ struct Context {
 	int					  deviceCount = -1; // device count
 	std::array<size_t, 3> setting;			// setting (cudaStreams, cudaBlocks, cudaThreads)
 	// GridCSR::MetaData	  meta;				// Grid metadata
+	GridCSR::Reader		  reader;			// every grid file, however it is stored
 	struct {
 		uint32_t width, count;
 	} grid;
@@ -1,9 +1,9 @@
 #include "data_man.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
-#include <fcntl.h>
 #include <thread>
 
 #define CUDACHECK()                        \
@@ -26,8 +26,8 @@
 namespace Data
 {
 
-Manager::Manager(int const deviceID, fs::path const & folderPath)
-	: deviceID(deviceID), folderPath(folderPath)
+Manager::Manager(int const deviceID, std::shared_ptr<GridCSR::Reader const> reader)
+	: deviceID(deviceID), reader(reader)
 {
 
 	// Allocate Memory
@@ -145,7 +145,11 @@ void Manager::run()
 
 	std::thread([=] {
 		for (auto & tx : *this->reqMustAlloc) {
-			auto targetPath = fs::path(this->folderPath / fs::path(tx.key));
+			auto keyPath = fs::path(tx.key);
+			auto grid	 = this->reader->find(keyPath.stem().string());
+			auto type	 = size_t(std::find(std::begin(EXTENSION), std::end(EXTENSION),
+											keyPath.extension().string()) -
+								  std::begin(EXTENSION));
 
 			std::unique_lock<std::mutex> ul(this->mem.cacheMtx);
 			bool						 iHaveLock = true;
@@ -167,7 +171,7 @@ void Manager::run()
 				continue;
 			}
 
-			myInfo.byte = fs::file_size(targetPath);
+			myInfo.byte = this->reader->byte(grid, type);
 
 			while (true) {
 				myInfo.ptr = this->mem.buddy->allocate(myInfo.byte);
@@ -210,32 +214,15 @@ void Manager::run()
 				}
 			}
 
-			auto fp = open64(targetPath.c_str(), O_RDONLY);
-
-			constexpr uint64_t cDef		 = (1L << 30); // chunk Default
-			uint64_t		   chunkByte = (myInfo.byte < cDef) ? myInfo.byte : cDef;
-			uint64_t		   bytePos	 = 0;
+			// the reader copies the file, an encoded .col decoded on the way
 #ifdef USE_GDRCOPY
 			uint8_t * hostVisiblePtr =
 				(uint8_t *)((int64_t)myInfo.ptr -
 							((int64_t)this->mem.devPtr - (int64_t)this->mem.mapPtr));
-#endif
-
-			// printf("hostVisiblePtr=%p, devVisiblePtr=%p\n", hostVisiblePtr, myInfo.ptr);
-
-			while (bytePos < myInfo.byte) {
-				chunkByte = (myInfo.byte - bytePos > chunkByte) ? chunkByte : myInfo.byte - bytePos;
-#ifdef USE_GDRCOPY
-				auto loaded = read(fp, &(((uint8_t *)hostVisiblePtr)[bytePos]), chunkByte);
+			this->reader->read(grid, type, hostVisiblePtr);
 #else
-				auto loaded = read(fp, &(((uint8_t *)myInfo.ptr)[bytePos]), chunkByte);
+			this->reader->read(grid, type, myInfo.ptr);
 #endif
-				// printf("key=%s, myInfo.ptr=%p, loaded=%d\n", tx.key.c_str(), myInfo.ptr, loaded);
-				assert(loaded > -1);
-				bytePos += loaded;
-			}
-
-			close(fp);
 
 			if (iHaveLock) {
 				ul.unlock();
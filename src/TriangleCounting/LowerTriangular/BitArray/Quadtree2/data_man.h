@@ -4,6 +4,7 @@
 #include "type.h"
 
 #include <BuddySystem/BuddySystem.h>
+#include <GridCSR/Reader.h>
 #include <boost/fiber/buffered_channel.hpp>
 #include <cuda.h>
 #include <gdrapi.h>
@@ -18,7 +19,7 @@ struct MemInfo {
 	size_t byte;
 };
 
-using Key = std::string;
+using Key = std::string; // a grid name and one of EXTENSION
 struct Value {
 	MemInfo info;
 	int		refCnt;
@@ -52,10 +53,10 @@ private:
 	std::shared_ptr<boost::fibers::buffered_channel<Req>> reqQ;
 	std::shared_ptr<boost::fibers::buffered_channel<Req>> reqMustAlloc;
 
-	fs::path folderPath;
+	std::shared_ptr<GridCSR::Reader const> reader;
 
 public:
-	Manager(int const deviceID, fs::path const & folderPath);
+	Manager(int const deviceID, std::shared_ptr<GridCSR::Reader const> reader);
 	~Manager();
 
 	void run();
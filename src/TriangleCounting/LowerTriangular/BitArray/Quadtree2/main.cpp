@@ -27,9 +27,23 @@ int main(int argc, char * argv[])
 
 	auto sched = std::make_shared<Sched::Manager>(folderPath);
 
+	auto reader = std::make_shared<GridCSR::Reader>();
+	reader->open(folderPath);
+
+	// the kernels take 32 bit .ptr entries only
+	for (size_t i = 0; i < reader->grids(); i++) {
+		if (reader->ptrBits(i) > 32) {
+			fprintf(stderr,
+					"%s: 64 bit .ptr in grid %s\n",
+					argv[0],
+					reader->meta.grid.each[i].name.c_str());
+			exit(EXIT_FAILURE);
+		}
+	}
+
 	std::vector<std::shared_ptr<Data::Manager>> data(devices);
 	for (int i = 0; i < devices; i++) {
-		data[i] = std::make_shared<Data::Manager>(i, folderPath);
+		data[i] = std::make_shared<Data::Manager>(i, reader);
 	}
 
 	std::vector<std::shared_ptr<Exec::Manager>> exec(devices * setting.stream);
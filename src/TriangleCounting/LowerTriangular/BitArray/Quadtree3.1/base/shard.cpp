@@ -4,7 +4,13 @@
 
 std::string ShardIndex::string() const
 {
-	if (this->depth > 0) {
+	if (this->depth > 0 && this->ranged) {
+		return std::to_string(this->grid[0]) + "-" + std::to_string(this->grid[1]) + "," +
+			   std::to_string(this->depth) + "," + std::to_string(this->shard[0]) + "-" +
+			   std::to_string(this->shard[1]) + "," + std::to_string(this->range[0][0]) + "-" +
+			   std::to_string(this->range[0][1]) + "," + std::to_string(this->range[1][0]) +
+			   "-" + std::to_string(this->range[1][1]);
+	} else if (this->depth > 0) {
 		return std::to_string(this->grid[0]) + "-" + std::to_string(this->grid[1]) + "," +
 			   std::to_string(this->depth) + "," + std::to_string(this->shard[0]) + "-" +
 			   std::to_string(this->shard[1]);
@@ -19,7 +25,8 @@ bool ShardIndex::parse(std::string const & in)
 		0,
 	};
 
-	std::regex	regex("^(\\d*)-(\\d*)(?:,(\\d*),(\\d*)-(\\d*))?$");
+	std::regex	regex(
+		"^(\\d*)-(\\d*)(?:,(\\d*),(\\d*)-(\\d*)(?:,(\\d*)-(\\d*),(\\d*)-(\\d*))?)?$");
 	std::smatch m;
 
 	if (std::regex_match(in, m, regex)) {
@@ -45,6 +52,14 @@ bool ShardIndex::parse(std::string const & in)
 			this->shard[1] = strtol(std::string(m[5]).c_str(), nullptr, 10);
 		}
 
+		if (m[6].length() > 0 && m[7].length() > 0 && m[8].length() > 0 && m[9].length() > 0) {
+			this->ranged	  = true;
+			this->range[0][0] = strtol(std::string(m[6]).c_str(), nullptr, 10);
+			this->range[0][1] = strtol(std::string(m[7]).c_str(), nullptr, 10);
+			this->range[1][0] = strtol(std::string(m[8]).c_str(), nullptr, 10);
+			this->range[1][1] = strtol(std::string(m[9]).c_str(), nullptr, 10);
+		}
+
 		return true;
 	} else {
 		return false;
@@ -63,6 +78,18 @@ void ShardRange::conv(ShardIndex const & in)
 	}
 }
 
+// ranged shards are not aligned to a depth; their ranges are taken at vertex resolution
+void ShardRange::span(ShardIndex const & in, size_t const widthExp)
+{
+	constexpr auto s = 0, t = 1; // start, terminate
+
+	this->depth = widthExp;
+	for (size_t i = 0; i < this->range.size(); i++) {
+		this->range[i][s] = (size_t(in.grid[i]) << widthExp) + in.range[i][s];
+		this->range[i][t] = (size_t(in.grid[i]) << widthExp) + in.range[i][t];
+	}
+}
+
 bool ShardRange::increase(size_t const depth)
 {
 	auto diff = depth - this->depth;
@@ -27,12 +27,34 @@ public:
 
 #include "base/type.h"
 
-using Grid	= std::array<DataInfo<uint32_t>, 3>;
-using Grids = std::array<Grid, 3>;
+#include <GridCSR/RowIndex.h>
+#include <array>
+#include <vector>
+
+// Index is the type of .ptr entries and of every edge offset derived from them: uint32_t, or
+// uint64_t in a grid of 2^32 edges or more
+template <typename Index>
+struct Grid {
+	DataInfo<uint32_t> row;
+	DataInfo<Index>	   ptr;
+	DataInfo<uint32_t> col;
+
+	// the converter's row index; without one the rows are found through a dense lookup
+	GridCSR::RowIndex index;
+	bool			  indexed = false;
+};
+
+template <typename Index>
+using Grids = std::array<Grid<Index>, 3>;
+
+template <typename Index>
+using Lookup = std::vector<Index>;
 
-using Lookup  = std::vector<uint32_t>;
-using Lookups = std::array<Lookup, 3>;
+template <typename Index>
+using Lookups = std::array<Lookup<Index>, 3>;
 
-Count countingCPU(Grids const & Gs, Lookups & Ls);
+// instantiated for uint32_t and uint64_t; Ls go unused when G0 and G2 have row indexes
+template <typename Index>
+Count countingCPU(Grids<Index> const & Gs, Lookups<Index> & Ls);
 
 #endif /* DD290292_80F2_4286_9FBC_3BD2FE246214 */
@@ -82,47 +82,79 @@ static ssize_t bsPos(uint32_t const * arr, uint32_t const arrLen, uint32_t const
 	return -1;
 }
 
-static void genLookupTemp(uint32_t const tid, uint32_t const ts, Grid const & G, Lookup & L)
+template <typename Index>
+static void
+genLookupTemp(uint32_t const tid, uint32_t const ts, Grid<Index> const & G, Lookup<Index> & L)
 {
-	for (uint32_t i = tid; i < G[0].count(); i += ts) {
-		L[G[0][i]] = G[1][i + 1] - G[1][i];
+	for (uint32_t i = tid; i < G.row.count(); i += ts) {
+		L[G.row[i]] = G.ptr[i + 1] - G.ptr[i];
 	}
 }
 
-static void resetLookupTemp(uint32_t const tid, uint32_t const ts, Grid const & G, Lookup & L)
+template <typename Index>
+static void
+resetLookupTemp(uint32_t const tid, uint32_t const ts, Grid<Index> const & G, Lookup<Index> & L)
 {
-	for (uint32_t i = tid; i < G[0].count(); i += ts) {
-		L[G[0][i]] = 0;
+	for (uint32_t i = tid; i < G.row.count(); i += ts) {
+		L[G.row[i]] = 0;
 	}
 }
 
-static Count kernel(uint32_t const tid, uint32_t const ts, Grids const & Gs, Lookups const & Ls)
+// [s, e) of the edges of row v of grid g, from the lookups countingCPU() filled
+template <typename Index>
+struct LookupRows {
+	Lookups<Index> const & Ls;
+
+	void operator()(int const g, uint32_t const v, Index & s, Index & e) const
+	{
+		s = this->Ls[g][v];
+		e = this->Ls[g][v + 1];
+	}
+};
+
+// the same from the converter's row indexes, nothing to fill per job
+template <typename Index>
+struct IndexedRows {
+	Grids<Index> const & Gs;
+
+	void operator()(int const g, uint32_t const v, Index & s, Index & e) const
+	{
+		this->Gs[g].index.find(v, this->Gs[g].ptr.addr, s, e);
+	}
+};
+
+template <typename Index, typename Rows>
+static Count
+kernel(uint32_t const tid, uint32_t const ts, Grids<Index> const & Gs, Rows const & rows)
 {
 	Count mycount = 0UL;
 
-	for (uint32_t g1row_iter = tid; g1row_iter < Gs[1][0].count(); g1row_iter += ts) {
+	for (uint32_t g1row_iter = tid; g1row_iter < Gs[1].row.count(); g1row_iter += ts) {
 
 		// This makes huge difference!!!
 		// Without "Existing Row" information: loop all 2^24 and check it all
 		// With "Existing Row" information: extremely faster than without-version
-		auto const g1row	   = Gs[1][0][g1row_iter];
-		auto const g2col_idx_s = Ls[2][g1row], g2col_idx_e = Ls[2][g1row + 1];
+		auto const g1row = Gs[1].row[g1row_iter];
+
+		Index g2col_idx_s, g2col_idx_e;
+		rows(2, g1row, g2col_idx_s, g2col_idx_e);
 
 		if (g2col_idx_s == g2col_idx_e) {
 			continue;
 		}
 
-		auto const g1col_idx_s = Gs[1][1][g1row_iter];
-		auto const g1col_idx_e = Gs[1][1][g1row_iter + 1];
+		auto const g1col_idx_s = Gs[1].ptr[g1row_iter];
+		auto const g1col_idx_e = Gs[1].ptr[g1row_iter + 1];
 
 		// variable for binary tree intersection
 		auto const g1col_length = g1col_idx_e - g1col_idx_s;
 		mycount++;
 
-		for (uint32_t g2col_idx = g2col_idx_s; g2col_idx < g2col_idx_e; g2col_idx++) {
-			auto const g2col = Gs[2][2][g2col_idx];
+		for (Index g2col_idx = g2col_idx_s; g2col_idx < g2col_idx_e; g2col_idx++) {
+			auto const g2col = Gs[2].col[g2col_idx];
 
-			auto const g0col_idx_s = Ls[0][g2col], g0col_idx_e = Ls[0][g2col + 1];
+			Index g0col_idx_s, g0col_idx_e;
+			rows(0, g2col, g0col_idx_s, g0col_idx_e);
 			if (g0col_idx_s == g0col_idx_e) {
 				continue;
 			}
@@ -130,11 +162,11 @@ static Count kernel(uint32_t const tid, uint32_t const ts, Grids const & Gs, Loo
 			auto const g0col_length = g0col_idx_e - g0col_idx_s;
 
 			if (g1col_length >= g0col_length) {
-				for (uint32_t g0col_idx = 0; g0col_idx < g0col_idx_e; g0col_idx++) {
+				for (Index g0col_idx = 0; g0col_idx < g0col_idx_e; g0col_idx++) {
 					// bsInter(&Gs[1][2][g1col_idx_s], g1col_length, Gs[0][2][g0col_idx], &mycount);
 				}
 			} else {
-				for (uint32_t g1col_idx = 0; g1col_idx < g1col_idx_e; g1col_idx++) {
+				for (Index g1col_idx = 0; g1col_idx < g1col_idx_e; g1col_idx++) {
 					// bsInter(&Gs[0][2][g0col_idx_s], g0col_length, Gs[1][2][g1col_idx], &mycount);
 				}
 			}
@@ -149,48 +181,48 @@ static Count kernel(uint32_t const tid, uint32_t const ts, Grids const & Gs, Loo
 #include <tbb/parallel_scan.h>
 #include <thread>
 
-Count countingCPU(Grids const & Gs, Lookups & Ls)
+template <typename Index>
+Count countingCPU(Grids<Index> const & Gs, Lookups<Index> & Ls)
 {
+	auto const indexed = Gs[0].indexed && Gs[2].indexed;
+
+	// Lout[v] takes the edges of the rows below v; Ltemp holds the row lengths meanwhile and is
+	// all zeros again afterwards
+	auto fill = [&](Grid<Index> const & G, Lookup<Index> & Ltemp, Lookup<Index> & Lout) {
+		genLookupTemp(0, 1, G, Ltemp);
+
+		// Lout[i + 1] takes the sum up to i, so the scan stops one short of the end
+		tbb::parallel_scan(
+			tbb::blocked_range<size_t>(0, Ltemp.size() - 1),
+			Index(0),
+			[&](tbb::blocked_range<size_t> const & r, Index sum, bool isFinalScan) {
+				auto temp = sum;
+				for (size_t i = r.begin(); i != r.end(); i++) {
+					temp += Ltemp[i];
+					if (isFinalScan) {
+						Lout[i + 1] = temp;
+					}
+				}
+				return temp;
+			},
+			[&](Index const & l, Index const & r) { return l + r; },
+			tbb::auto_partitioner());
+
+		resetLookupTemp(0, 1, G, Ltemp);
+	};
+
+	// a dense lookup of width + 1 entries for G0 and G2, rebuilt per job without row indexes
+	if (!indexed) {
+		fill(Gs[0], Ls[1], Ls[0]);
+		fill(Gs[2], Ls[1], Ls[2]);
+	}
 
 	std::vector<std::thread> T(std::thread::hardware_concurrency());
 	std::vector<Count>		 R(T.size());
 	for (size_t t = 0; t < T.size(); t++) {
 		T[t] = std::thread([&, t] {
-			Count myCount = 0;
-
-			auto fill = [&](Grid const & G, Lookup & Ltemp, Lookup & Lout) {
-				genLookupTemp(t, T.size(), G, Lout);
-
-				tbb::parallel_scan(
-					tbb::blocked_range<size_t>(0, Ltemp.size()),
-					0,
-					[&](tbb::blocked_range<size_t> const & r, uint32_t sum, bool isFinalScan) {
-						auto temp = sum;
-						for (size_t grain = r.begin(); grain != r.end(); grain += r.grainsize()) {
-							for (size_t offset = 0UL; offset < r.grainsize(); offset++) {
-								auto i = grain + offset;
-								temp += Ltemp[i];
-								if (isFinalScan) {
-									Lout[i + 1] = temp;
-								}
-							}
-						}
-						return temp;
-					},
-					[&](size_t const & l, size_t const & r) { return l + r; },
-					tbb::auto_partitioner());
-
-				resetLookupTemp(t, T.size(), G, Lout);
-			};
-
-			// fill Ls[0]
-			fill(Gs[0], Ls[1], Ls[0]);
-
-			// fill Ls[2]
-			fill(Gs[2], Ls[1], Ls[2]);
-
-			// run
-			R[t] = kernel(t, T.size(), Gs, Ls);
+			R[t] = (indexed) ? kernel(t, T.size(), Gs, IndexedRows<Index>{Gs})
+							 : kernel(t, T.size(), Gs, LookupRows<Index>{Ls});
 		});
 	}
 
@@ -201,4 +233,7 @@ Count countingCPU(Grids const & Gs, Lookups & Ls)
 	}
 
 	return std::accumulate(R.begin(), R.end(), 0UL);
-}
\ No newline at end of file
+}
+
+template Count countingCPU<uint32_t>(Grids<uint32_t> const & Gs, Lookups<uint32_t> & Ls);
+template Count countingCPU<uint64_t>(Grids<uint64_t> const & Gs, Lookups<uint64_t> & Ls);
@@ -2,56 +2,88 @@
 
 #include <algorithm>
 
-void GridInfo::init(fs::path const & folderPath)
+// a shard of an older converter, which listed no statistics; its ranges are taken from the name
+static GridInfoValue
+gridNamed(GridCSR::Reader const & reader, size_t const i, size_t const widthExp)
 {
-	uint32_t SIZEMAX = 0;
-	for (fs::recursive_directory_iterator curr(folderPath), end; curr != end; ++curr) {
-		if (fs::is_regular_file(curr->path()) && fs::file_size(curr->path()) > 0 &&
-			curr->path().extension() == EXTENSION[0]) {
-			auto stem = curr->path().stem().string();
-
-			ShardIndex sIdx;
-			sIdx.parse(stem);
-			SIZEMAX = std::max(std::max(sIdx.grid[0], sIdx.grid[1]), SIZEMAX);
-		}
+	ShardIndex sIdx;
+	sIdx.parse(reader.meta.grid.each[i].name);
+
+	ShardRange sRange;
+	if (sIdx.ranged) {
+		sRange.span(sIdx, widthExp);
+	} else {
+		sRange.conv(sIdx);
+		sRange.increase(widthExp);
 	}
-	SIZEMAX++;
 
-	this->matrix.resize(SIZEMAX);
-	for (auto & row : this->matrix) {
-		row.resize(SIZEMAX);
+	GridInfoValue value;
+	value.grid	= sIdx.grid;
+	value.depth = sIdx.depth;
+	value.shard = sIdx.shard;
+	value.range = sRange.range;
+
+	for (size_t t = 0; t < reader.files(); t++) {
+		value.byte[t] = reader.byte(i, t);
 	}
 
-	uint32_t gridID = 0;
+	value.ptrBits = reader.ptrBits(i);
+	return value;
+}
 
-	for (fs::recursive_directory_iterator curr(folderPath), end; curr != end; ++curr) {
-		if (fs::is_regular_file(curr->path()) && fs::file_size(curr->path()) > 0 &&
-			curr->path().extension() == EXTENSION[0]) {
-			auto stem = curr->path().stem().string();
+// a shard the converter listed, without touching the shard files
+static GridInfoValue gridListed(GridCSR::Reader const & reader, size_t const i)
+{
+	auto const & g = reader.meta.grid.each[i];
 
-			ShardIndex sIdx;
-			sIdx.parse(stem);
+	GridInfoValue value;
+	value.grid	= {uint32_t(g.index.row), uint32_t(g.index.col)};
+	value.depth = g.depth;
+	value.shard = {uint32_t(g.shard.row), uint32_t(g.shard.col)};
+	value.range = {{{g.range.row.begin, g.range.row.end}, {g.range.col.begin, g.range.col.end}}};
 
-			ShardRange sRange;
-			sRange.conv(sIdx);
-			sRange.increase(24);
+	// an encoded .col takes more room once the reader decoded it
+	for (size_t t = 0; t < reader.files(); t++) {
+		value.byte[t] = reader.byte(i, t);
+	}
 
-			GridInfoValue value;
-			value.id	= gridID;
-			value.grid	= sIdx.grid;
-			value.depth = sIdx.depth;
-			value.shard = sIdx.shard;
-			value.range = sRange.range;
+	value.ptrBits = g.ptr_bits;
+	return value;
+}
 
-			for (int i = 0; i < 3; i++) {
-				value.path[i] = std::string(folderPath / fs::path(stem + EXTENSION[i]));
-				value.byte[i] = fs::file_size(value.path[i]);
-			}
+void GridInfo::init(GridCSR::Reader const & reader)
+{
+	// grid width chosen by the converter; folders without metadata keep the fixed width
+	this->width = (reader.hasMeta) ? reader.meta.info.width.row : GRIDWIDTH;
 
-			this->matrix[value.grid[0]][value.grid[1]].push_back(value);
+	size_t widthExp = 0;
+	while ((1UL << widthExp) < this->width) {
+		widthExp++;
+	}
 
-			gridID++;
-		}
+	// in the reader's order, so a grid's id is its position there
+	std::vector<GridInfoValue> list;
+	for (size_t i = 0; i < reader.grids(); i++) {
+		list.push_back((reader.meta.grid.detail) ? gridListed(reader, i)
+												 : gridNamed(reader, i, widthExp));
+	}
+
+	uint32_t SIZEMAX = 0;
+	for (auto & value : list) {
+		SIZEMAX = std::max(std::max(value.grid[0], value.grid[1]), SIZEMAX);
+	}
+	SIZEMAX++;
+
+	this->matrix.resize(SIZEMAX);
+	for (auto & row : this->matrix) {
+		row.resize(SIZEMAX);
+	}
+
+	uint32_t gridID = 0;
+	for (auto & value : list) {
+		value.id = gridID;
+		this->matrix[value.grid[0]][value.grid[1]].push_back(value);
+		gridID++;
 	}
 
 	for (auto & row : this->matrix) {
@@ -61,4 +93,4 @@ void GridInfo::init(fs::path const & folderPath)
 			}
 		}
 	}
-}
\ No newline at end of file
+}
@@ -4,31 +4,32 @@
 #include "base/shard.h"
 #include "base/type.h"
 
+#include <GridCSR/Reader.h>
 #include <array>
 #include <string.h>
 #include <unordered_map>
 #include <vector>
 
 struct GridInfoValue {
-	uint32_t							 id;
+	uint32_t							 id; // position of the grid in the GridCSR::Reader
 	std::array<uint32_t, 2>				 grid;
 	uint32_t							 depth;
 	std::array<uint32_t, 2>				 shard;
 	std::array<std::array<size_t, 2>, 2> range;
-	std::array<size_t, 3>				 byte;
-	std::array<std::string, 3>			 path;
+	std::array<size_t, 4>				 byte;	  // in memory, after decoding; [3]: row index
+	uint32_t							 ptrBits; // of a .ptr entry, 32 or 64
 
-	GridInfoValue() { memset((void *)this, 0x00, sizeof(*this)); }
+	GridInfoValue() : id(0), grid{}, depth(0), shard{}, range{}, byte{}, ptrBits(32) {}
 
 	GridInfoValue(GridInfoValue const & copy)
 	{
-		this->id	= copy.id;
-		this->grid	= copy.grid;
-		this->depth = copy.depth;
-		this->shard = copy.shard;
-		this->range = copy.range;
-		this->byte	= copy.byte;
-		this->path	= copy.path;
+		this->id	  = copy.id;
+		this->grid	  = copy.grid;
+		this->depth	  = copy.depth;
+		this->shard	  = copy.shard;
+		this->range	  = copy.range;
+		this->byte	  = copy.byte;
+		this->ptrBits = copy.ptrBits;
 	}
 };
 
@@ -37,6 +38,7 @@ struct GridInfoValue {
 struct GridInfo {
 	std::vector<std::vector<std::vector<GridInfoValue>>> matrix;
 	std::unordered_map<uint32_t, GridInfoValue *>		 hashmap;
+	uint32_t											 width; // from meta.json when there is one
 
 	std::vector<GridInfoValue> & xy(uint32_t const row, uint32_t const col)
 	{
@@ -61,7 +63,7 @@ struct GridInfo {
 	GridInfoValue &		  id(uint32_t const id) { return *this->hashmap[id]; }
 	GridInfoValue const & id(uint32_t const id) const { return *(this->hashmap.at(id)); }
 
-	void init(fs::path const & folderPath);
+	void init(GridCSR::Reader const & reader);
 };
 
 #endif /* D0A9018F_9699_40C9_A354_DBD2CFAD848A */
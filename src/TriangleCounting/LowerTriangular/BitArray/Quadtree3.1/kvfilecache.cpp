@@ -2,35 +2,21 @@
 
 #include "util/logging.h"
 
-#include <fcntl.h>
-#include <unistd.h>
-
 bool KeyValueFileCache::tryAlloc(int const myDeviceID, void ** addr, size_t byte)
 {
-	if (myDeviceID < 0) {
-		*addr = malloc(byte);
-		if (addr == nullptr) {
-			return false;
-		}
-	} else {
-		try {
-			cudaSetDevice(myDeviceID);
-			*addr = this->device_pool[myDeviceID]->allocate(byte);
-		} catch (rmm::bad_alloc e) {
-			return false;
-		}
+	try {
+		cudaSetDevice(myDeviceID);
+		*addr = this->device_pool[myDeviceID]->allocate(byte);
+	} catch (rmm::bad_alloc e) {
+		return false;
 	}
 	return true;
 }
 
 void KeyValueFileCache::mustDealloc(int const myDeviceID, void * addr, size_t byte)
 {
-	if (myDeviceID < 0) {
-		free(addr);
-	} else {
-		cudaSetDevice(myDeviceID);
-		this->device_pool[myDeviceID]->deallocate(addr, byte);
-	}
+	cudaSetDevice(myDeviceID);
+	this->device_pool[myDeviceID]->deallocate(addr, byte);
 }
 
 void KeyValueFileCache::loadToMe(int const				myDeviceID,
@@ -38,38 +24,20 @@ void KeyValueFileCache::loadToMe(int const				myDeviceID,
 								 FileInfoValue const &	myInfo,
 								 DataInfo<void> const & otherInfo)
 {
-	if (myDeviceID < 0) {
-		// SSD->CPU
-		auto const __CDEF = 1UL << 26;
-
-		auto fp = open64(myInfo.path.c_str(), O_RDONLY);
+	cudaMemcpyKind kind;
 
-		uint64_t chunkSize = (myInfo.byte < __CDEF) ? myInfo.byte : __CDEF;
-		uint64_t offset	   = 0;
-
-		while (offset < myInfo.byte) {
-			chunkSize = (myInfo.byte - offset > chunkSize) ? chunkSize : myInfo.byte - offset;
-			auto b	  = read(fp, &(((uint8_t *)myInfo.addr)[offset]), chunkSize);
-			offset += b;
-		}
-
-		close(fp);
+	if (otherDeviceID < 0) {
+		// CPU -> GPU
+		kind = cudaMemcpyHostToDevice;
 	} else {
-		cudaMemcpyKind kind;
-
-		if (otherDeviceID < 0) {
-			// CPU -> GPU
-			kind = cudaMemcpyHostToDevice;
-		} else {
-			// GPU->GPU
-			kind = cudaMemcpyDeviceToDevice;
-		}
-
-		cudaSetDevice(myDeviceID);
-		cudaMemcpyAsync(
-			myInfo.addr, otherInfo.addr, myInfo.byte, kind, this->cudaLoadingStream[myDeviceID]);
-		cudaStreamSynchronize(this->cudaLoadingStream[myDeviceID]);
+		// GPU->GPU
+		kind = cudaMemcpyDeviceToDevice;
 	}
+
+	cudaSetDevice(myDeviceID);
+	cudaMemcpyAsync(
+		myInfo.addr, otherInfo.addr, myInfo.byte, kind, this->cudaLoadingStream[myDeviceID]);
+	cudaStreamSynchronize(this->cudaLoadingStream[myDeviceID]);
 }
 
 bool KeyValueFileCache::tryPrepareNVLink(int const				otherDeviceID,
@@ -91,8 +59,11 @@ bool KeyValueFileCache::tryPrepareNVLink(int const				otherDeviceID,
 	return false;
 }
 
-void KeyValueFileCache::init(GridInfo const & gridInfo)
+void KeyValueFileCache::init(GridInfo const & gridInfo, GridCSR::Reader const & reader)
 {
+	this->reader = &reader;
+
+
 	cudaGetDeviceCount(&this->devices);
 	this->fileInfo.resize(this->devices + 1);
 	for (auto & f : this->fileInfo) {
@@ -101,9 +72,8 @@ void KeyValueFileCache::init(GridInfo const & gridInfo)
 
 	for (size_t i = 0; i < this->fileInfo.size(); i++) {
 		for (auto const & kv : gridInfo.hashmap) {
-			for (uint32_t fileType = 0; fileType < 3; fileType++) {
+			for (uint32_t fileType = 0; fileType < reader.files(); fileType++) {
 				FileInfoValue value;
-				value.path	= kv.second->path[fileType];
 				value.byte	= kv.second->byte[fileType];
 				value.state = FileState::notexist;
 
@@ -206,8 +176,8 @@ DataInfo<void> KeyValueFileCache::mustPrepare(int myDeviceID, DataManagerKey con
 		}
 	}
 
-	// FileState = loading, evicting
-	while (![&] {
+	// FileState = loading, evicting; only a GPU allocates, the CPU serves views of the reader
+	while (myDeviceID >= 0 && ![&] {
 		std::lock_guard<std::mutex> lg(target.lock);
 		return this->tryAlloc(myDeviceID, &target.addr, target.byte);
 	}()) {
@@ -239,8 +209,12 @@ DataInfo<void> KeyValueFileCache::mustPrepare(int myDeviceID, DataManagerKey con
 	DataInfo<void> otherInfo;
 	int			   otherDeviceID = -2;
 	if (myDeviceID < 0) {
-		// SSD->CPU
-		this->loadToMe(myDeviceID, otherDeviceID, target, otherInfo);
+		// SSD->CPU: the file mapped in place, or decoded when it is encoded
+		auto view = this->reader->file(key.gridID, key.fileType);
+
+		std::lock_guard<std::mutex> lg(target.lock);
+		target.view = view;
+		target.addr = (void *)view.addr;
 	} else {
 		// search other GPU
 
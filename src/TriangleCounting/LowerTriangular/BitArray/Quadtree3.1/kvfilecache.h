@@ -5,6 +5,7 @@
 #include "base/type.h"
 #include "gridinfo.h"
 
+#include <GridCSR/Reader.h>
 #include <array>
 #include <cuda_runtime.h>
 #include <jemalloc/jemalloc.h>
@@ -37,18 +38,18 @@ private:
 	struct FileInfoValue {
 		std::mutex lock;
 
-		FileState state;
-		size_t	  refCount;
-		void *	  addr;
-		size_t	  byte;
-		fs::path  path;
+		FileState		  state;
+		size_t			  refCount;
+		void *			  addr;
+		size_t			  byte;
+		GridCSR::FileView view; // holds addr on the CPU
 
 		FileInfoValue & operator=(FileInfoValue const & copy)
 		{
 			this->state	   = copy.state;
 			this->refCount = copy.refCount;
 			this->byte	   = copy.byte;
-			this->path	   = copy.path;
+			this->view	   = copy.view;
 
 			return *this;
 		}
@@ -80,20 +81,23 @@ private:
 	bool
 	tryPrepareNVLink(int const otherDeviceID, DataManagerKey const & key, DataInfo<void> & info);
 
-	// hashmap function: for my device
+	// hashmap function: for my GPU
 	bool tryAlloc(int const myDeviceID, void ** addr, size_t byte);
 	void mustDealloc(int const myDeviceID, void * addr, size_t byte);
 
-	// loading function
+	// loading function: for GPU
 	void loadToMe(int const				 myDeviceID,
 				  int const				 otherDeviceID,
 				  FileInfoValue const &	 myInfo,
 				  DataInfo<void> const & otherInfo);
 
+	// the CPU serves views of the reader, no copies
+	GridCSR::Reader const * reader;
+
 public:
 	int devices;
 
-	void init(GridInfo const & gridInfo);
+	void init(GridInfo const & gridInfo, GridCSR::Reader const & reader);
 	~KeyValueFileCache() noexcept;
 
 	DataInfo<void> mustPrepare(int const myDeviceID, DataManagerKey const & key);
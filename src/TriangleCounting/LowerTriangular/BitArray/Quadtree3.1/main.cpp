@@ -13,6 +13,48 @@
 #include <iostream>
 #include <string>
 
+// counts a job on the CPU with Index offsets; a grid with a 32 bit .ptr in a job that needs 64 bit
+// ones is widened into wide
+template <typename Index>
+static Count countingJob(std::array<std::array<DataInfo<void>, 4>, 3> const & info,
+						 Lookups<Index> &									 Ls,
+						 std::array<std::vector<Index>, 3> &				 wide,
+						 uint32_t const										 width)
+{
+	Grids<Index> Gs;
+	for (int g = 0; g < 3; g++) {
+		Gs[g].row.addr = (uint32_t *)info[g][0].addr;
+		Gs[g].row.byte = info[g][0].byte;
+		Gs[g].col.addr = (uint32_t *)info[g][2].addr;
+		Gs[g].col.byte = info[g][2].byte;
+
+		auto entries = Gs[g].row.count() + 1;
+		if (info[g][1].byte == entries * sizeof(Index)) {
+			Gs[g].ptr.addr = (Index *)info[g][1].addr;
+		} else {
+			auto narrow = (uint32_t const *)info[g][1].addr;
+			wide[g].assign(narrow, narrow + entries);
+			Gs[g].ptr.addr = wide[g].data();
+		}
+		Gs[g].ptr.byte = entries * sizeof(Index);
+
+		if (info[g][3].addr != nullptr) {
+			auto const & idx = info[g][3];
+			Gs[g].index = GridCSR::RowIndex(idx.addr, idx.byte, Gs[g].row.addr, Gs[g].row.count());
+			Gs[g].indexed = true;
+		}
+	}
+
+	// the dense lookups are only needed without row indexes
+	if (!Gs[0].indexed || !Gs[2].indexed) {
+		for (auto & L : Ls) {
+			L.resize(size_t(width) + 1);
+		}
+	}
+
+	return countingCPU(Gs, Ls);
+}
+
 int main(int argc, char * argv[])
 {
 	if (argc != 2) {
@@ -22,12 +64,19 @@ int main(int argc, char * argv[])
 
 	auto folderPath = fs::path(fs::path(std::string(argv[1]) + "/").parent_path().string() + "/");
 
+	GridCSR::Reader reader;
+	reader.open(folderPath);
+	LOG("Complete: reader open");
+
+	// row, ptr, col, and the row index when the converter wrote one
+	int const files = reader.files();
+
 	GridInfo gridInfo;
-	gridInfo.init(folderPath);
+	gridInfo.init(reader);
 	LOG("Complete: gridInfo init");
 
 	KeyValueFileCache cache;
-	cache.init(gridInfo);
+	cache.init(gridInfo, reader);
 	LOG("Complete: cache init");
 
 	cache.devices = 0;
@@ -45,13 +94,14 @@ int main(int argc, char * argv[])
 #endif
 		runner[myDevID + 1] = std::thread([&, myDevID] {
 			LOGF("runner %d launching...", myDevID);
-			std::array<std::array<DataInfo<void>, 3>, 3> info;
+			std::array<std::array<DataInfo<void>, 4>, 3> info{};
 			Job											 job;
 
-			Lookups Ls;
-			for (auto & L : Ls) {
-				L.resize((1UL << 24) + 1);
-			}
+			// a job runs on 64 bit offsets when one of its grids has a 64 bit .ptr
+			Lookups<uint32_t>					  Ls;
+			Lookups<uint64_t>					  Ls64;
+			std::array<std::vector<uint32_t>, 3> wide;
+			std::array<std::vector<uint64_t>, 3> wide64;
 
 			while (sched.fetchJob(myDevID, job)) {
 				// LOGF("I am %d ==> Job: <%d, %d, %d>", myDevID, job[0], job[1], job[2]);
@@ -64,7 +114,7 @@ int main(int argc, char * argv[])
 					boost::asio::thread_pool myPool(9);
 
 					for (int g = 0; g < 3; g++) {
-						for (int t = 0; t < 3; t++) {
+						for (int t = 0; t < files; t++) {
 							boost::asio::post(myPool, [&, g, t] {
 								DataManagerKey key;
 								key.gridID	 = job[g];
@@ -84,14 +134,13 @@ int main(int argc, char * argv[])
 				{
 					auto start = std::chrono::system_clock::now();
 					if (myDevID < 0) {
-						Grids Gs;
+						auto ptrWide = false;
 						for (int g = 0; g < 3; g++) {
-							for (int t = 0; t < 3; t++) {
-								Gs[g][t].addr = (uint32_t *)info[g][t].addr;
-								Gs[g][t].byte = info[g][t].byte;
-							}
+							ptrWide = ptrWide || gridInfo.id(job[g]).ptrBits == 64;
 						}
-						triangles = countingCPU(Gs, Ls);
+						triangles = (ptrWide)
+										? countingJob(info, Ls64, wide64, gridInfo.width)
+										: countingJob(info, Ls, wide, gridInfo.width);
 					} else {
 						// triangles	= countingGPU(info);
 					}
@@ -101,7 +150,7 @@ int main(int argc, char * argv[])
 
 				boost::asio::thread_pool myPool(9);
 				for (int g = 0; g < 3; g++) {
-					for (int t = 0; t < 3; t++) {
+					for (int t = 0; t < files; t++) {
 						boost::asio::post(myPool, [&, g, t] {
 							DataManagerKey key;
 							key.gridID	 = job[g];